@@ -1,3 +1,7 @@
 ./src/generator.py > ./src/generated.h
+./src/generator.py desc > ./src/opdesc.h
 mkdir -p bin
-gcc ./src/main.c -O2 -Wall -o ./bin/gb-disasm
+gcc ./src/main.c -O2 -Wall -pthread -o ./bin/gb-disasm -lm
+gcc ./test/bench.c -O2 -Wall -pthread -o ./bin/gb-bench -lm
+gcc ./test/microbench.c -O2 -Wall -pthread -o ./bin/gb-microbench -lm
+gcc ./src/opsbin.c -O2 -Wall -o ./bin/gb-opsbin
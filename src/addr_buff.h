@@ -2,28 +2,36 @@
 #define __GB_DASM_ADDR_LIST_H__
 
 #include "stdinc.h"
+#include "mem.h"
 
 typedef struct addr_buff {
     uint32_t*   addr;
     int         len;
     int         reserved;
+    /** Added offsets below total, bit per offset, NULL if not kept. Not owned, buffers can
+        share it. */
+    uint64_t*   map;
+    uint32_t    total;
 } addr_buff;
 
 void addr_buff_init(addr_buff* buff) {
     /* Initially 1024 elements. */
-    buff->addr = (uint32_t*)malloc(4096);
+    buff->addr = (uint32_t*)mem_alloc(MEM_TARGETS, 4096);
     buff->len = 0;
     buff->reserved = 1024;
+    buff->map = NULL;
+    buff->total = 0;
 }
 
 void addr_buff_add(addr_buff* buff, uint32_t addr) {
+    if(buff->map && addr < buff->total) buff->map[addr >> 6] |= 1ULL << (addr & 63);
     if(buff->len + 1 < buff->reserved) {
         buff->addr[buff->len++] = addr;
     } else {
         uint32_t* new_addr;
-        new_addr = (uint32_t*)malloc(buff->reserved << 3);
+        new_addr = (uint32_t*)mem_alloc(MEM_TARGETS, buff->reserved << 3);
         memcpy(new_addr, buff->addr, buff->len<<2);
-        free(buff->addr);
+        mem_free(buff->addr);
         buff->addr = new_addr;
         buff->reserved <<= 1;
         printf("[DEBUG] Resizing to %d\n", buff->reserved);
@@ -32,7 +40,7 @@ void addr_buff_add(addr_buff* buff, uint32_t addr) {
 }
 
 void addr_buff_free(addr_buff* buff) {
-    if(buff->addr) free(buff->addr);
+    if(buff->addr) mem_free(buff->addr);
 }
 
 #endif
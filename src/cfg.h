@@ -0,0 +1,251 @@
+#ifndef __GB_DASM_CFG_H__
+#define __GB_DASM_CFG_H__
+
+/* cfg.h: Basic blocks and control flow graph. */
+
+#include "sops.h"
+#include "opdesc.h"
+
+/* Edge kinds. */
+#define CFG_EDGE_FALL       0 /* to the next block */
+#define CFG_EDGE_BRANCH     1 /* jump, conditional or not */
+#define CFG_EDGE_CALL       2 /* call or RST to the subroutine */
+#define CFG_EDGE_RETURN     3 /* call to return site */
+
+/** Maximum number of edges leaving a block. */
+#define CFG_MAX_OUT         2
+
+/** Control flow graph, blocks are numbered by address so ids are stable.
+    Edges of block b are edge_dst[edge_off[b]] .. edge_dst[edge_off[b+1]-1] (CSR). */
+typedef struct cfg {
+    /** Number of blocks. */
+    int         len;
+    /** First operation of block. */
+    op**        first;
+    /** Block start and end (after last instruction) offsets. */
+    uint32_t*   start;
+    uint32_t*   end;
+    /** Number of edges. */
+    int         edges;
+    /** Edges offsets, len+1 elements. */
+    uint32_t*   edge_off;
+    /** Destination blocks. */
+    uint32_t*   edge_dst;
+    /** Edge kinds. */
+    uint8_t*    edge_kind;
+    /** Leaders bitmap with rank per 64 bits, for offset to block id mapping. */
+    uint64_t*   leaders;
+    uint32_t*   rank;
+    uint32_t    total;
+} cfg;
+
+/** Block id of leader at off, -1 if off is not a block start. */
+int cfg_block(const cfg* g, uint32_t off) {
+    uint64_t w;
+
+    if(off >= g->total) return -1;
+    w = g->leaders[off >> 6];
+    if(!(w & (1ULL << (off & 63)))) return -1;
+    return g->rank[off >> 6] + popcount64(w & ((1ULL << (off & 63)) - 1));
+}
+
+/** Control flow class of operation. */
+int cfg_flow(const op* o) {
+    if(o->flags & OP_FLAG_IS_DATA) return OPDESC_FLOW_NONE;
+    return OPDESC_FLOW[o->code[0]];
+}
+
+/** Branch or call destination offset of operation, total if none. */
+uint32_t cfg_dest(const op* o, uint32_t total) {
+    switch(cfg_flow(o)) {
+        case OPDESC_FLOW_RST:
+            return o->code[0] & 0x38;
+        case OPDESC_FLOW_JUMP:
+        case OPDESC_FLOW_BRANCH:
+        case OPDESC_FLOW_CALL:
+            if(o->flags & OP_FLAG_IS_JUMP) return o->addr;
+    }
+    return total;
+}
+
+/** Operation ends basic block. */
+int cfg_ends_block(const op* o) {
+    return (o->flags & OP_FLAG_IS_DATA) || cfg_flow(o) != OPDESC_FLOW_NONE;
+}
+
+/** Builds graph from operations list, linear in number of operations. */
+cfg* cfg_build(op* head, uint32_t total) {
+    cfg*        g;
+    op*         tmp;
+    uint64_t*   starts;
+    uint32_t    words, i, dst;
+    int         b, leader;
+
+    g = (cfg*)mem_calloc(MEM_ANALYSIS, 1, sizeof(cfg));
+    g->total = total;
+    words = (total >> 6) + 1;
+    starts = (uint64_t*)mem_calloc(MEM_ANALYSIS, words, sizeof(uint64_t));
+    g->leaders = (uint64_t*)mem_calloc(MEM_ANALYSIS, words, sizeof(uint64_t));
+    g->rank = (uint32_t*)mem_alloc(MEM_ANALYSIS, words * sizeof(uint32_t));
+
+    /* instructions starts, data words are not part of blocks */
+    for(tmp = head; tmp; tmp = tmp->next)
+        if(!(tmp->flags & OP_FLAG_IS_DATA))
+            starts[tmp->off >> 6] |= 1ULL << (tmp->off & 63);
+
+    /* leaders: after gap or block end, and every destination */
+    leader = 1;
+    for(tmp = head; tmp; tmp = tmp->next) {
+        if(tmp->flags & OP_FLAG_IS_DATA) {
+            leader = 1;
+            continue;
+        }
+        if(leader || (tmp->flags & (OP_FLAG_JMP_ADDR | OP_FLAG_CALL_ADDR)))
+            g->leaders[tmp->off >> 6] |= 1ULL << (tmp->off & 63);
+        dst = cfg_dest(tmp, total);
+        if(dst < total && (starts[dst >> 6] & (1ULL << (dst & 63))))
+            g->leaders[dst >> 6] |= 1ULL << (dst & 63);
+        leader = cfg_ends_block(tmp) || !tmp->next || tmp->next->off != tmp->off + tmp->len;
+    }
+    mem_free(starts);
+
+    for(i=0, g->len=0; i<words; i++) {
+        g->rank[i] = g->len;
+        g->len += popcount64(g->leaders[i]);
+    }
+
+    g->first = (op**)mem_alloc(MEM_ANALYSIS, g->len * sizeof(op*));
+    g->start = (uint32_t*)mem_alloc(MEM_ANALYSIS, g->len * sizeof(uint32_t));
+    g->end = (uint32_t*)mem_alloc(MEM_ANALYSIS, g->len * sizeof(uint32_t));
+    g->edge_off = (uint32_t*)mem_alloc(MEM_ANALYSIS, (g->len + 1) * sizeof(uint32_t));
+    g->edge_dst = (uint32_t*)mem_alloc(MEM_ANALYSIS, g->len * CFG_MAX_OUT * sizeof(uint32_t));
+    g->edge_kind = (uint8_t*)mem_alloc(MEM_ANALYSIS, g->len * CFG_MAX_OUT);
+    g->edges = 0;
+
+    /* blocks and edges, operations are sorted so blocks come in id order */
+    b = -1;
+    for(tmp = head; tmp; tmp = tmp->next) {
+        int flow, next;
+
+        if(tmp->flags & OP_FLAG_IS_DATA) continue;
+        if(cfg_block(g, tmp->off) >= 0) {
+            b++;
+            g->first[b] = tmp;
+            g->start[b] = tmp->off;
+            g->edge_off[b] = g->edges;
+        }
+        g->end[b] = tmp->off + tmp->len;
+
+        /* edges leave the last operation of block */
+        next = -1;
+        if(tmp->next && !(tmp->next->flags & OP_FLAG_IS_DATA) && tmp->next->off == tmp->off + tmp->len) {
+            next = cfg_block(g, tmp->next->off);
+            if(next < 0) continue;
+        }
+
+        flow = cfg_flow(tmp);
+        dst = cfg_dest(tmp, total);
+        if(dst < total && cfg_block(g, dst) >= 0) {
+            g->edge_dst[g->edges] = cfg_block(g, dst);
+            g->edge_kind[g->edges++] = (flow == OPDESC_FLOW_CALL || flow == OPDESC_FLOW_RST) ?
+                CFG_EDGE_CALL : CFG_EDGE_BRANCH;
+        }
+        if(next >= 0) {
+            switch(flow) {
+                case OPDESC_FLOW_NONE:
+                case OPDESC_FLOW_BRANCH:
+                case OPDESC_FLOW_RETCC:
+                    g->edge_dst[g->edges] = next;
+                    g->edge_kind[g->edges++] = CFG_EDGE_FALL;
+                    break;
+                case OPDESC_FLOW_CALL:
+                case OPDESC_FLOW_RST:
+                    g->edge_dst[g->edges] = next;
+                    g->edge_kind[g->edges++] = CFG_EDGE_RETURN;
+                    break;
+            }
+        }
+    }
+    g->edge_off[g->len] = g->edges;
+
+    return g;
+}
+
+void cfg_free(cfg* g) {
+    if(!g) return;
+    mem_free(g->first);
+    mem_free(g->start);
+    mem_free(g->end);
+    mem_free(g->edge_off);
+    mem_free(g->edge_dst);
+    mem_free(g->edge_kind);
+    mem_free(g->leaders);
+    mem_free(g->rank);
+    mem_free(g);
+}
+
+/** Graphviz node with block instructions. */
+void cfg_dot_block(const cfg* g, FILE* f, int b) {
+    op* tmp;
+
+    fprintf(f, "\tb%d [label=\"%x:\\l", b, g->start[b]);
+    for(tmp = g->first[b]; tmp && tmp->off < g->end[b]; tmp = tmp->next)
+        fprintf(f, "%s\\l", tmp->name);
+    fprintf(f, "\"];\n");
+}
+
+void cfg_dot_edges(const cfg* g, FILE* f, int b, const uint8_t* mark) {
+    static const char* STYLE[] = { "solid", "bold", "dashed", "dotted" };
+    uint32_t e;
+
+    for(e = g->edge_off[b]; e < g->edge_off[b+1]; e++)
+        if(!mark || mark[g->edge_dst[e]])
+            fprintf(f, "\tb%d -> b%d [style=%s];\n", b, g->edge_dst[e], STYLE[g->edge_kind[e]]);
+}
+
+/** Graphviz export of blocks in physical range lo-hi. */
+void cfg_dot_range(const cfg* g, FILE* f, uint32_t lo, uint32_t hi) {
+    int b;
+
+    fprintf(f, "digraph cfg {\n\tnode [shape=box fontname=monospace];\n");
+    for(b=0; b<g->len; b++)
+        if(g->start[b] >= lo && g->start[b] < hi) cfg_dot_block(g, f, b);
+    for(b=0; b<g->len; b++)
+        if(g->start[b] >= lo && g->start[b] < hi) cfg_dot_edges(g, f, b, NULL);
+    fprintf(f, "}\n");
+}
+
+/** Graphviz export of function starting at off, blocks reachable without calls. */
+void cfg_dot_func(const cfg* g, FILE* f, uint32_t off) {
+    uint8_t*    mark;
+    uint32_t*   queue;
+    uint32_t    e;
+    int         b, head, tail;
+
+    if((b = cfg_block(g, off)) < 0) return;
+    mark = (uint8_t*)mem_calloc(MEM_ANALYSIS, g->len, 1);
+    queue = (uint32_t*)mem_alloc(MEM_ANALYSIS, g->len * sizeof(uint32_t));
+    head = tail = 0;
+    mark[b] = 1;
+    queue[tail++] = b;
+    while(head < tail) {
+        b = queue[head++];
+        for(e = g->edge_off[b]; e < g->edge_off[b+1]; e++) {
+            if(g->edge_kind[e] == CFG_EDGE_CALL || mark[g->edge_dst[e]]) continue;
+            mark[g->edge_dst[e]] = 1;
+            queue[tail++] = g->edge_dst[e];
+        }
+    }
+
+    fprintf(f, "digraph sub_%x {\n\tnode [shape=box fontname=monospace];\n", off);
+    for(b=0; b<g->len; b++)
+        if(mark[b]) cfg_dot_block(g, f, b);
+    for(b=0; b<g->len; b++)
+        if(mark[b]) cfg_dot_edges(g, f, b, mark);
+    fprintf(f, "}\n");
+
+    mem_free(queue);
+    mem_free(mark);
+}
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef __GB_DASM_CLASSIFY_H__
+#define __GB_DASM_CLASSIFY_H__
+
+/* classify.h: Code or data guess for bytes traversal didn't reach, --classify.
+
+   Opcode pair frequencies are learned from decoded instructions. Every gap of
+   unknown bytes is walked once as instructions and split into blocks ending
+   with jump or return. Block score in bits is sum of its opcode pair log
+   likelihood ratios of learned model to random bytes, plus evidence of jump and
+   call targets: start of block used as target by decoded instruction, targets
+   of block landing on decoded instructions. Block with invalid opcode, target
+   inside instruction or data or too repetitive bytes is data. Starts of code
+   blocks are seeds for traversal. */
+
+#include "sops.h"
+#include "opdesc.h"
+#include "fill.h"
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** Shortest code block in bytes. */
+#define CLASSIFY_MIN_BYTES      8
+/** Score of code block, log2 likelihood ratio. */
+#define CLASSIFY_MIN_BITS       16.0
+/** Score of block starting at target of decoded instruction. */
+#define CLASSIFY_REF_BITS       16.0
+/** Score of block with target landing on decoded instruction. */
+#define CLASSIFY_HIT_BITS       4.0
+/** Model is used from this count of learned pairs, score is evidence of targets otherwise. */
+#define CLASSIFY_MIN_PAIRS      1024
+/** Model evidence of block needs this average per pair, longer random bytes reach any sum. */
+#define CLASSIFY_MIN_PAIR_BITS  1.0
+/** Weight of single opcode frequency in pair probability. */
+#define CLASSIFY_BACKOFF        16.0
+/** Byte entropy of code block relative to the highest one for its length. */
+#define CLASSIFY_MIN_ENTROPY    0.5
+/** Seeding and traversal repeats, seeded code makes the model and gaps better. */
+#define CLASSIFY_ROUNDS         16
+
+typedef struct classifier {
+    /** Opcode pairs of consecutive instructions, 256x256, and first opcode counts. */
+    uint32_t*   pairs;
+    uint32_t    firsts[0x100];
+    uint32_t    learned;
+    /** Opcode counts of all instructions. */
+    uint32_t    opcodes[0x100];
+    uint32_t    decoded;
+    /** Log2 ratio of pair probability to random byte. */
+    float*      bits;
+    /** Targets of decoded instructions, bit per offset, traversal keeps it. */
+    const uint64_t* refs;
+    uint32_t    total;
+    /** Byte counts of current block. */
+    uint16_t    hist[0x100];
+    uint32_t*   seeds;
+    int         len;
+    int         reserved;
+    /** Blocks scored and found as code. */
+    uint32_t    blocks;
+    uint32_t    code;
+} classifier;
+
+void classify_init(classifier* c, uint32_t total, const uint64_t* refs) {
+    memset(c, 0, sizeof(classifier));
+    c->total = total;
+    c->refs = refs;
+    c->pairs = (uint32_t*)mem_calloc(MEM_ANALYSIS, 0x10000, sizeof(uint32_t));
+    c->bits = (float*)mem_alloc(MEM_ANALYSIS, 0x10000 * sizeof(float));
+}
+
+void classify_free(classifier* c) {
+    mem_free(c->pairs);
+    mem_free(c->bits);
+    mem_free(c->seeds);
+}
+
+/** First offset from off until to with unknown state, or with known one. */
+uint32_t classify_skip(const uint8_t* own, uint32_t off, uint32_t to, int unknown) {
+#ifdef __SSE2__
+    const __m128i   mask = _mm_set1_epi8(OWN_STATE);
+    uint32_t        m;
+
+    for(; off + 16 <= to; off += 16) {
+        m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(
+            _mm_loadu_si128((const __m128i*)(own + off)), mask), _mm_setzero_si128()));
+        if(!unknown) m = ~m & 0xFFFF;
+        if(m) return off + ctz64(m);
+    }
+#endif
+    for(; off < to && ((own[off] & OWN_STATE) == OWN_UNKNOWN) != unknown; off++);
+    return off;
+}
+
+/** Counts opcode pairs of adjacent decoded instructions, operation starts are walked by
+    bitmap words, data words are skipped. */
+void classify_learn(classifier* c, const sops_idx* x, const rom* r) {
+    uint32_t    w, off, next = 0;
+    uint64_t    bits;
+    uint8_t     code, prev = 0;
+    int         i;
+
+    memset(c->pairs, 0, 0x10000 * sizeof(uint32_t));
+    memset(c->firsts, 0, sizeof(c->firsts));
+    memset(c->opcodes, 0, sizeof(c->opcodes));
+    c->learned = c->decoded = 0;
+    for(w=0; w<=(r->total >> 6); w++) {
+        for(bits = x->starts[w]; bits; bits &= bits - 1) {
+            off = (w << 6) + ctz64(bits);
+            if((x->own[off] & OWN_STATE) != OWN_CODE || !OPDESC_LEN[code = r->raw[off]]) continue;
+            c->opcodes[code]++;
+            c->decoded++;
+            if(off == next && off) {
+                c->pairs[(prev << 8) | code]++;
+                c->firsts[prev]++;
+                c->learned++;
+            }
+            prev = code;
+            next = off + OPDESC_LEN[code];
+        }
+    }
+    /* P(next | first) backed off to P(next) for rare firsts, against 1/256 */
+    for(i=0; i<0x10000; i++)
+        c->bits[i] = (float)log2((c->pairs[i] + CLASSIFY_BACKOFF * (c->opcodes[i & 0xFF] + 1.0) /
+            (c->decoded + 256.0)) * 256.0 / (c->firsts[i >> 8] + CLASSIFY_BACKOFF));
+}
+
+/** Offset is target of decoded instruction, followed or not. */
+int classify_ref(const classifier* c, uint32_t off) {
+    return (c->refs[off >> 6] >> (off & 63)) & 1;
+}
+
+void classify_seed(classifier* c, uint32_t off) {
+    if(c->len == c->reserved) {
+        c->reserved = c->reserved ? c->reserved * 2 : 256;
+        c->seeds = (uint32_t*)mem_realloc(MEM_ANALYSIS, c->seeds, c->reserved * sizeof(uint32_t));
+    }
+    c->seeds[c->len++] = off;
+}
+
+/** Physical offset of logical address used at offset, -1 if it is not known or outside of ROM,
+    -2 for video and cartridge RAM, code doesn't run there. */
+int64_t classify_target(const rom* r, uint32_t off, uint16_t addr, uint16_t end) {
+    uint32_t toff;
+
+    if(addr >= 0x8000 && addr < 0xC000) return -2;
+    if(addr >= end) return -1;
+    if(addr < 0x4000)
+        toff = addr;
+    else if(off >= 0x4000)
+        toff = (off & ~0x3FFFU) + addr - 0x4000;
+    else
+        return -1; /* bank 0 to switched bank, bank is not known */
+    return toff < r->total ? (int64_t)toff : -1;
+}
+
+/** Byte entropy of block relative to the highest one for its length, counts are cleared. */
+double classify_entropy(classifier* c, const uint8_t* p, uint32_t n) {
+    double      h = 0, q;
+    uint32_t    i;
+
+    for(i=0; i<n; i++) {
+        if(!c->hist[p[i]]) continue;
+        q = (double)c->hist[p[i]] / n;
+        h -= q * log2(q);
+        c->hist[p[i]] = 0;
+    }
+    return n > 1 ? h / log2(n < 256 ? n : 256) : 0;
+}
+
+/** Scores block from offset until end offset (excluded) walked as instructions. */
+int classify_block(classifier* c, const uint8_t* raw, uint32_t from, uint32_t to,
+        double bits, uint32_t count, uint32_t hits) {
+    double score = 0;
+
+    c->blocks++;
+    if(to - from < CLASSIFY_MIN_BYTES || !count) return 0;
+    /* model is positive evidence only, it is learned from reached code, which can be one kind */
+    if(c->learned >= CLASSIFY_MIN_PAIRS && count > 1 && bits / (count - 1) >= CLASSIFY_MIN_PAIR_BITS)
+        score += bits;
+    if(classify_ref(c, from)) score += CLASSIFY_REF_BITS;
+    if(hits) score += CLASSIFY_HIT_BITS;
+    if(score < CLASSIFY_MIN_BITS) return 0;
+    if(classify_entropy(c, raw + from, to - from) < CLASSIFY_MIN_ENTROPY) return 0;
+    c->code++;
+    return 1;
+}
+
+/** Forgets byte counts of block from offset until end offset (excluded). */
+void classify_drop(classifier* c, const uint8_t* raw, uint32_t from, uint32_t to) {
+    for(; from < to; from++) c->hist[raw[from]] = 0;
+}
+
+/** Walks gap from offset until end offset (excluded) and seeds its code blocks. */
+void classify_gap(classifier* c, const sops_idx* x, const rom* r, uint32_t from, uint32_t to, uint16_t end) {
+    const uint8_t*  raw = r->raw;
+    uint32_t        p = from, s = from, count = 0, hits = 0, len, i;
+    double          bits = 0;
+    int             bad = 0, stop;
+    uint8_t         code, prev = 0, flow, own;
+    int64_t         t;
+    uint16_t        addr;
+
+    while(p < to) {
+        code = raw[p];
+        len = OPDESC_LEN[code];
+        /* target starts block, unfinished one before it is dropped */
+        if(p > s && classify_ref(c, p)) {
+            classify_drop(c, raw, s, p);
+            s = p;
+            count = hits = 0;
+            bits = 0;
+            bad = 0;
+        }
+        for(i=1; i<len && p+i < to && !classify_ref(c, p+i); i++);
+        /* invalid or cut opcode, or target inside it, next block starts after it or at target */
+        if(!len || p + len > to || i < len) {
+            classify_drop(c, raw, s, p);
+            p += (len && p + len <= to) ? i : 1;
+            s = p;
+            count = hits = 0;
+            bits = 0;
+            bad = 0;
+            continue;
+        }
+        for(i=0; i<len; i++) c->hist[raw[p+i]]++;
+        if(count) bits += c->bits[(prev << 8) | code];
+        count++;
+        prev = code;
+
+        /* targets must start instructions, hits are decoded ones */
+        flow = OPDESC_FLOW[code];
+        t = -1;
+        if(flow == OPDESC_FLOW_JUMP || flow == OPDESC_FLOW_BRANCH || flow == OPDESC_FLOW_CALL) {
+            addr = (uint16_t)(p < 0x4000 ? p : 0x4000 + (p & 0x3FFF));
+            if(len == 3)
+                t = classify_target(r, p, raw[p+1] | (raw[p+2] << 8), end);
+            else
+                t = classify_target(r, p, addr + 2 + (int8_t)raw[p+1], end);
+        }
+        if(t == -2)
+            bad = 1;
+        else if(t >= 0) {
+            own = x->own[t] & OWN_STATE;
+            if(own == OWN_CODE) hits++;
+            else if(own != OWN_UNKNOWN) bad = 1;
+        }
+        p += len;
+
+        stop = flow == OPDESC_FLOW_JUMP || flow == OPDESC_FLOW_RET || flow == OPDESC_FLOW_JPHL;
+        if(stop || p >= to) {
+            if(!bad && stop && classify_block(c, raw, s, p, bits, count, hits))
+                classify_seed(c, s);
+            else
+                classify_drop(c, raw, s, p);
+            s = p;
+            count = hits = 0;
+            bits = 0;
+            bad = 0;
+        }
+    }
+}
+
+/** Gap without fill regions and cartridge header. */
+void classify_run(classifier* c, const sops_idx* x, const rom* r, const fills* fs,
+        uint32_t from, uint32_t to, uint16_t end) {
+    const fill* fl;
+    int         i;
+
+    if(from < 0x150 && to > 0x104) {
+        if(from < 0x104) classify_run(c, x, r, fs, from, 0x104, end);
+        if(to > 0x150) classify_run(c, x, r, fs, 0x150, to, end);
+        return;
+    }
+    if(fs->list)
+        for(i = fills_find(fs, from); i < fs->len && fs->list[i].off < to; i++) {
+            fl = &fs->list[i];
+            if(fl->off > from) classify_gap(c, x, r, from, fl->off, end);
+            from = fl->off + fl->len;
+        }
+    if(from < to) classify_gap(c, x, r, from, to, end);
+}
+
+/** Finds seeds in bytes not owned by operations, fill regions and cartridge header.
+    Addresses from end are not followed. Returns count of seeds. */
+int classify_gaps(classifier* c, const sops_idx* x, const rom* r, const fills* fs, uint16_t end) {
+    uint32_t lo, limit, off, to;
+
+    c->len = 0;
+    /* gaps don't cross banks, logical end limits every bank */
+    for(lo=0; lo<r->total; lo += 0x4000) {
+        limit = lo + (lo == 0 ? (end < 0x4000 ? end : 0x4000) : (end > 0x4000 ? end - 0x4000 : 0));
+        if(limit > r->total) limit = r->total;
+        for(off = lo; (off = classify_skip(x->own, off, limit, 1)) < limit; off = to) {
+            to = classify_skip(x->own, off, limit, 0);
+            classify_run(c, x, r, fs, off, to, end);
+        }
+    }
+    return c->len;
+}
+
+#endif
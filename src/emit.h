@@ -0,0 +1,127 @@
+#ifndef __GB_DASM_EMIT_H__
+#define __GB_DASM_EMIT_H__
+
+/* emit.h: Parallel assembly emission.
+
+   Operations list is split into chunks of fixed number of operations, every
+   chunk is formatted into memory buffer by pool worker, starting from the end
+   of the operation before it, so gap lines are the same as in sops_asm.
+   Buffers are written in order with writev, few chunks per thread at a time. */
+
+#include "sops.h"
+#include "pool.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifndef EMIT_CHUNK_OPS
+#define EMIT_CHUNK_OPS  4096
+#endif
+/** Chunks per thread formatted before they are written. */
+#define EMIT_WINDOW     4
+/** Buffers per writev call, POSIX minimum of IOV_MAX. */
+#define EMIT_IOV        16
+
+typedef struct emit_chunk {
+    const op*   head;
+    const op*   stop;
+    /** End of operation before head. */
+    uint32_t    prev;
+    const rom*  r;
+    const syms* s;
+    char*       buf;
+    size_t      len;
+} emit_chunk;
+
+#ifndef _WIN32
+void emit_task(void* arg) {
+    emit_chunk* c = (emit_chunk*)arg;
+    FILE*       f = open_memstream(&c->buf, &c->len);
+
+    sops_asm_range(c->head, c->stop, c->prev, f, c->r, c->s);
+    fclose(f);
+}
+
+/** Writes buffers in order, returns -1 on error. */
+int emit_writev(int fd, struct iovec* iov, int n) {
+    ssize_t w;
+
+    while(n > 0) {
+        w = writev(fd, iov, n > EMIT_IOV ? EMIT_IOV : n);
+        if(w < 0) {
+            if(errno == EINTR) continue;
+            return -1;
+        }
+        /* partial write continues in the middle of buffer */
+        while(n > 0 && (size_t)w >= iov->iov_len) {
+            w -= iov->iov_len;
+            iov++;
+            n--;
+        }
+        if(n > 0) {
+            iov->iov_base = (char*)iov->iov_base + w;
+            iov->iov_len -= w;
+        }
+    }
+    return 0;
+}
+#endif
+
+/** Same output as sops_asm, formatted on threads, at most one per CPU. Returns -1 if output
+    could not be written. */
+int emit_asm(op* head, FILE* f, rom* r, const syms* s, int threads, events* ev) {
+#ifndef _WIN32
+    pool*           p;
+    emit_chunk*     chunks;
+    struct iovec*   iov;
+    const op*       o = head;
+    uint32_t        prev = 0;
+    int             window, n, i, ret = 0;
+
+    /* more threads than CPUs only add hand-offs */
+    if(threads > pool_cpus()) threads = pool_cpus();
+    if(threads > 1) {
+        sops_asm_equ(f, s, head, NULL);
+        fprintf(f, "SECTION \"rom0\", HOME[0]\n");
+        fflush(f);
+        p = pool_create(threads);
+        p->trace = ev;
+        window = threads * EMIT_WINDOW;
+        chunks = (emit_chunk*)mem_calloc(MEM_OUTPUT, window, sizeof(emit_chunk));
+        iov = (struct iovec*)mem_alloc(MEM_OUTPUT, window * sizeof(struct iovec));
+        while(o) {
+            for(n=0; n<window && o; n++) {
+                chunks[n].head = o;
+                chunks[n].prev = prev;
+                chunks[n].r = r;
+                chunks[n].s = s;
+                for(i=0; i<EMIT_CHUNK_OPS && o; i++) {
+                    prev = o->off + o->len;
+                    o = o->next;
+                }
+                chunks[n].stop = o;
+                pool_submit(p, emit_task, &chunks[n]);
+            }
+            pool_wait(p);
+            for(i=0; i<n; i++) {
+                iov[i].iov_base = chunks[i].buf;
+                iov[i].iov_len = chunks[i].len;
+            }
+            if(!ret && emit_writev(fileno(f), iov, n) < 0) ret = -1;
+            for(i=0; i<n; i++) free(chunks[i].buf); /* open_memstream buffers */
+        }
+        pool_free(p);
+        mem_free(chunks);
+        mem_free(iov);
+        sops_asm_tail(prev, f, r);
+        return ret;
+    }
+#endif
+    sops_asm(head, f, r, s);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,354 @@
+#ifndef __GB_DASM_EMITTER_H__
+#define __GB_DASM_EMITTER_H__
+
+/* emitter.h: Several outputs of operations list in one pass.
+
+   Every backend has begin, op and end functions, backends compiled in are
+   listed in EMITTER_BACKENDS and the pass calls them directly for every
+   operation, only those with output file open. Build can define its own list,
+   e.g. -D"EMITTER_BACKENDS(X)=X(ASM, asm) X(SYM, sym)". */
+
+#include "sops.h"
+#include "opsbin.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#define EMITTER_ASM     0
+#define EMITTER_DUMP    1
+#define EMITTER_SYM     2
+#define EMITTER_JSON    3
+#define EMITTER_BIN     4
+#define EMITTER_KINDS   5
+
+#ifndef EMITTER_BACKENDS
+#define EMITTER_BACKENDS(X) X(ASM, asm) X(DUMP, dump) X(SYM, sym) X(JSON, json) X(BIN, bin)
+#endif
+
+#define EMITTER_HASH_BITS   12
+
+/** Columns of binary output, written at the end when count is known. */
+typedef struct emitter_cols {
+    uint32_t    n;
+    uint32_t    reserved;
+    uint32_t*   off;
+    uint8_t*    len;
+    uint8_t*    code;
+    uint8_t*    flags;
+    uint32_t*   target;
+    uint16_t*   desc;
+    uint32_t*   text;
+    uint32_t*   label;
+    /** String table, same strings are stored once. */
+    char*       strings;
+    uint32_t    strings_len;
+    uint32_t    strings_reserved;
+    /** String offsets + 1 by hash, 0 is empty slot. */
+    uint32_t*   hash;
+    uint32_t    hash_size;
+    uint32_t    hash_used;
+} emitter_cols;
+
+typedef struct emitter {
+    FILE*       out[EMITTER_KINDS];
+    const rom*  r;
+    const syms* s;
+    /** Operations of the pass, assembly defines their RAM symbols first. */
+    const op*   head;
+    /** Assembly, end of previous operation. */
+    uint32_t    prev;
+    /** Symbols, imported symbols merged so far. */
+    sops_sym_cursor sym;
+    /** JSON, operations written. */
+    uint32_t    json_ops;
+    /** Binary columns. */
+    emitter_cols cols;
+} emitter;
+
+void emitter_init(emitter* e, const rom* r, const syms* s) {
+    memset(e, 0, sizeof(emitter));
+    e->r = r;
+    e->s = s;
+}
+
+/** Backend is compiled in. */
+int emitter_has(int kind) {
+#define EMITTER_HAS(K, name) if(kind == EMITTER_##K) return 1;
+    EMITTER_BACKENDS(EMITTER_HAS)
+#undef EMITTER_HAS
+    return 0;
+}
+
+/** Output of backend to file, "-" is stdout. Returns -1 if file could not be opened
+    or backend is not compiled in. */
+int emitter_open(emitter* e, int kind, const char* filename) {
+    if(!emitter_has(kind)) return -1;
+    if(strcmp(filename, "-") == 0) {
+        e->out[kind] = stdout;
+#ifdef _WIN32
+        if(kind == EMITTER_BIN) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    } else if(!(e->out[kind] = fopen(filename, kind == EMITTER_BIN ? "wb" : "w")))
+        return -1;
+    return 0;
+}
+
+/* Assembly, same as sops_asm. */
+void emitter_asm_begin(emitter* e, FILE* f) {
+    sops_asm_equ(f, e->s, e->head, NULL);
+    fprintf(f, "SECTION \"rom0\", HOME[0]\n");
+    e->prev = 0;
+}
+
+void emitter_asm_op(emitter* e, FILE* f, const op* o) {
+    sops_asm_gap(e->prev, o, f, e->r);
+    sops_asm_op(f, o, e->s);
+    e->prev = o->off + o->len;
+}
+
+void emitter_asm_end(emitter* e, FILE* f) {
+    sops_asm_tail(e->prev, f, e->r);
+}
+
+/* Hex dump, same as sops_dump. */
+void emitter_dump_begin(emitter* e, FILE* f) {
+}
+
+void emitter_dump_op(emitter* e, FILE* f, const op* o) {
+    sops_dump_op(f, o);
+}
+
+void emitter_dump_end(emitter* e, FILE* f) {
+}
+
+/* Symbols file, same as sops_sym. */
+void emitter_sym_begin(emitter* e, FILE* f) {
+    sops_sym_begin(&e->sym, f, e->s);
+}
+
+void emitter_sym_op(emitter* e, FILE* f, const op* o) {
+    sops_sym_op(&e->sym, f, e->s, o);
+}
+
+void emitter_sym_end(emitter* e, FILE* f) {
+    sops_sym_end(&e->sym, f, e->s);
+}
+
+/* JSON, operation per line with offset, bytes, text, labels and target. */
+void emitter_json_str(FILE* f, const char* p) {
+    fputc('"', f);
+    for(; *p; p++) {
+        if(*p == '"' || *p == '\\')
+            fprintf(f, "\\%c", *p);
+        else if((uint8_t)*p < 0x20)
+            fprintf(f, "\\u%.4x", (uint8_t)*p);
+        else
+            fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+void emitter_json_begin(emitter* e, FILE* f) {
+    fprintf(f, "{\"rom\":");
+    emitter_json_str(f, e->r->filename);
+    fprintf(f, ",\"size\":%u,\"ops\":[", e->r->total);
+    e->json_ops = 0;
+}
+
+void emitter_json_op(emitter* e, FILE* f, const op* o) {
+    const char* name = syms_label(e->s, o->off);
+    int         i;
+
+    fprintf(f, "%s\n{\"off\":%u,\"bytes\":\"", e->json_ops++ ? "," : "", o->off);
+    for(i=0; i<o->len; i++)
+        fprintf(f, "%.2X", o->code[i]);
+    fprintf(f, "\",\"text\":");
+    emitter_json_str(f, o->name);
+    if(name) {
+        fprintf(f, ",\"label\":");
+        emitter_json_str(f, name);
+    } else if(o->flags & (OP_FLAG_JMP_ADDR | OP_FLAG_CALL_ADDR))
+        fprintf(f, ",\"label\":\"%s%x\"", o->flags & OP_FLAG_CALL_ADDR ? "sub_" : "jmp_", o->off);
+    if(o->flags & OP_FLAG_IS_JUMP)
+        fprintf(f, ",\"target\":%u", o->addr);
+    if(o->flags & OP_FLAG_IS_DATA)
+        fprintf(f, ",\"data\":true");
+    fprintf(f, "}");
+}
+
+void emitter_json_end(emitter* e, FILE* f) {
+    fprintf(f, "\n]}\n");
+}
+
+/* Columnar binary, opsbin.h. */
+void emitter_bin_begin(emitter* e, FILE* f) {
+    emitter_cols* c = &e->cols;
+
+    memset(c, 0, sizeof(emitter_cols));
+    c->hash_size = 1 << EMITTER_HASH_BITS;
+    c->hash = (uint32_t*)mem_calloc(MEM_OUTPUT, c->hash_size, sizeof(uint32_t));
+}
+
+uint32_t emitter_bin_hash(const char* p) {
+    uint32_t h = 2166136261U;
+    while(*p) h = (h ^ (uint8_t)*p++) * 16777619U;
+    return h;
+}
+
+/** Offset of string in string table, added if it is not there. */
+uint32_t emitter_bin_string(emitter_cols* c, const char* p) {
+    uint32_t    mask = c->hash_size - 1;
+    uint32_t    i, j, len, old_size;
+    uint32_t*   old;
+
+    for(i = emitter_bin_hash(p) & mask; c->hash[i]; i = (i + 1) & mask)
+        if(strcmp(c->strings + c->hash[i] - 1, p) == 0) return c->hash[i] - 1;
+
+    len = strlen(p) + 1;
+    while(c->strings_len + len > c->strings_reserved) {
+        c->strings_reserved = c->strings_reserved ? c->strings_reserved * 2 : 4096;
+        c->strings = (char*)mem_realloc(MEM_OUTPUT, c->strings, c->strings_reserved);
+    }
+    memcpy(c->strings + c->strings_len, p, len);
+    c->hash[i] = c->strings_len + 1;
+    c->strings_len += len;
+
+    /* rehash at half load */
+    if(++c->hash_used * 2 > c->hash_size) {
+        old = c->hash;
+        old_size = c->hash_size;
+        c->hash_size *= 2;
+        mask = c->hash_size - 1;
+        c->hash = (uint32_t*)mem_calloc(MEM_OUTPUT, c->hash_size, sizeof(uint32_t));
+        for(j=0; j<old_size; j++) {
+            if(!old[j]) continue;
+            for(i = emitter_bin_hash(c->strings + old[j] - 1) & mask; c->hash[i]; i = (i + 1) & mask);
+            c->hash[i] = old[j];
+        }
+        mem_free(old);
+    }
+    return c->strings_len - len;
+}
+
+void emitter_bin_op(emitter* e, FILE* f, const op* o) {
+    emitter_cols*   c = &e->cols;
+    const char*     name = syms_label(e->s, o->off);
+    char            label[16];
+    uint32_t        n = c->n;
+
+    if(n == c->reserved) {
+        c->reserved = c->reserved ? c->reserved * 2 : 4096;
+        c->off = (uint32_t*)mem_realloc(MEM_OUTPUT, c->off, c->reserved * sizeof(uint32_t));
+        c->len = (uint8_t*)mem_realloc(MEM_OUTPUT, c->len, c->reserved);
+        c->code = (uint8_t*)mem_realloc(MEM_OUTPUT, c->code, c->reserved * 3);
+        c->flags = (uint8_t*)mem_realloc(MEM_OUTPUT, c->flags, c->reserved);
+        c->target = (uint32_t*)mem_realloc(MEM_OUTPUT, c->target, c->reserved * sizeof(uint32_t));
+        c->desc = (uint16_t*)mem_realloc(MEM_OUTPUT, c->desc, c->reserved * sizeof(uint16_t));
+        c->text = (uint32_t*)mem_realloc(MEM_OUTPUT, c->text, c->reserved * sizeof(uint32_t));
+        c->label = (uint32_t*)mem_realloc(MEM_OUTPUT, c->label, c->reserved * sizeof(uint32_t));
+    }
+    c->off[n] = o->off;
+    c->len[n] = o->len;
+    c->code[n * 3] = o->code[0];
+    c->code[n * 3 + 1] = o->len > 1 ? o->code[1] : 0;
+    c->code[n * 3 + 2] = o->len > 2 ? o->code[2] : 0;
+    c->flags[n] = o->flags;
+    c->target[n] = o->flags & OP_FLAG_IS_JUMP ? o->addr : OPSBIN_NONE;
+    if(o->flags & OP_FLAG_IS_DATA)
+        c->desc[n] = OPSBIN_DESC_DATA;
+    else if(o->code[0] == 0xCB)
+        c->desc[n] = OPSBIN_DESC_CB | o->code[1];
+    else
+        c->desc[n] = o->code[0];
+    c->text[n] = emitter_bin_string(c, o->name);
+    /* same label as JSON output, imported symbol or call label first */
+    if(!name && (o->flags & (OP_FLAG_JMP_ADDR | OP_FLAG_CALL_ADDR))) {
+        sprintf(label, "%s%x", o->flags & OP_FLAG_CALL_ADDR ? "sub_" : "jmp_", o->off);
+        name = label;
+    }
+    c->label[n] = name ? emitter_bin_string(c, name) : OPSBIN_NONE;
+    c->n++;
+}
+
+/** Column padded to 8 bytes. */
+void emitter_bin_column(FILE* f, const void* data, uint32_t size) {
+    static const char zero[8] = {0};
+    fwrite(data, 1, size, f);
+    fwrite(zero, 1, (8 - size % 8) % 8, f);
+}
+
+void emitter_bin_end(emitter* e, FILE* f) {
+    emitter_cols*   c = &e->cols;
+    opsbin_header   h;
+    uint32_t        n = c->n;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, OPSBIN_MAGIC, 4);
+    h.version = OPSBIN_VERSION;
+    h.count = n;
+    h.rom_size = e->r->total;
+    h.off = opsbin_next(0, 1, sizeof(h));
+    h.len = opsbin_next(h.off, n, 4);
+    h.code = opsbin_next(h.len, n, 1);
+    h.flags = opsbin_next(h.code, n, 3);
+    h.target = opsbin_next(h.flags, n, 1);
+    h.desc = opsbin_next(h.target, n, 4);
+    h.text = opsbin_next(h.desc, n, 2);
+    h.label = opsbin_next(h.text, n, 4);
+    h.strings = opsbin_next(h.label, n, 4);
+    h.strings_size = c->strings_len;
+
+    emitter_bin_column(f, &h, sizeof(h));
+    emitter_bin_column(f, c->off, n * 4);
+    emitter_bin_column(f, c->len, n);
+    emitter_bin_column(f, c->code, n * 3);
+    emitter_bin_column(f, c->flags, n);
+    emitter_bin_column(f, c->target, n * 4);
+    emitter_bin_column(f, c->desc, n * 2);
+    emitter_bin_column(f, c->text, n * 4);
+    emitter_bin_column(f, c->label, n * 4);
+    emitter_bin_column(f, c->strings, c->strings_len);
+
+    mem_free(c->off);
+    mem_free(c->len);
+    mem_free(c->code);
+    mem_free(c->flags);
+    mem_free(c->target);
+    mem_free(c->desc);
+    mem_free(c->text);
+    mem_free(c->label);
+    mem_free(c->strings);
+    mem_free(c->hash);
+}
+
+/** Writes every open output in one pass over operations, closes files.
+    Returns -1 if some output could not be written. */
+int emitter_run(emitter* e, const op* head) {
+    const op*   o;
+    int         k, ret = 0;
+
+#define EMITTER_BEGIN(K, name) if(e->out[EMITTER_##K]) emitter_##name##_begin(e, e->out[EMITTER_##K]);
+#define EMITTER_OP(K, name) if(e->out[EMITTER_##K]) emitter_##name##_op(e, e->out[EMITTER_##K], o);
+#define EMITTER_END(K, name) if(e->out[EMITTER_##K]) emitter_##name##_end(e, e->out[EMITTER_##K]);
+    e->head = head;
+    EMITTER_BACKENDS(EMITTER_BEGIN)
+    for(o = head; o; o = o->next) {
+        EMITTER_BACKENDS(EMITTER_OP)
+    }
+    EMITTER_BACKENDS(EMITTER_END)
+#undef EMITTER_BEGIN
+#undef EMITTER_OP
+#undef EMITTER_END
+
+    for(k=0; k<EMITTER_KINDS; k++) {
+        if(!e->out[k]) continue;
+        if(ferror(e->out[k])) ret = -1;
+        if(e->out[k] != stdout && fclose(e->out[k]) != 0) ret = -1;
+        e->out[k] = NULL;
+    }
+    return ret;
+}
+
+#endif
@@ -0,0 +1,287 @@
+#ifndef __GB_DASM_ENCODE_H__
+#define __GB_DASM_ENCODE_H__
+
+/* encode.h: SM83 re-encoder, round-trip check of disassembly without rgbds.
+
+   Instruction text is looked up in opcode descriptor text tables, operands of
+   jumps and calls are taken from their labels, as an assembler would resolve
+   them. Gaps are rebuilt by the same rules as data of sops_asm: INCBIN is copied
+   from ROM, DB lines are parsed back from hex.h text and REPT blocks repeat the
+   value of their fill region. */
+
+#include "sops.h"
+#include "opdesc.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define ENCODE_BITS     10
+
+/* Errors. */
+#define ENCODE_UNKNOWN  -1 /* text is not an instruction */
+#define ENCODE_LABEL    -2 /* jump target has no label */
+#define ENCODE_RANGE    -3 /* relative jump target too far */
+
+static const char* ENCODE_ERRORS[4] = {
+    "", "unknown instruction", "jump target has no label", "relative jump out of range"
+};
+
+/** Instruction text hash table, opcode + 1 (0x1xx for bit operations), 0 is empty slot. */
+typedef struct encoder {
+    uint16_t    table[1 << ENCODE_BITS];
+} encoder;
+
+/** Round-trip result. */
+typedef struct encode_result {
+    /** Encoded instructions and rebuilt image length. */
+    uint32_t    ops;
+    uint32_t    len;
+    /** Offset of first mismatch, -1 if image is identical. */
+    long        mismatch;
+    uint8_t     expected;
+    uint8_t     got;
+    /** First operation that could not be encoded and its error. */
+    const op*   error_op;
+    int         error;
+    int         errors;
+} encode_result;
+
+uint32_t encode_hash(const char* s) {
+    uint32_t h = 2166136261U;
+    while(*s) h = (h ^ (uint8_t)*s++) * 16777619U;
+    return h >> (32 - ENCODE_BITS);
+}
+
+void encode_insert(encoder* e, const char* text, int code) {
+    uint32_t i;
+    for(i = encode_hash(text); e->table[i]; i = (i + 1) & ((1 << ENCODE_BITS) - 1));
+    e->table[i] = (uint16_t)(code + 1);
+}
+
+void encode_init(encoder* e) {
+    int i;
+
+    memset(e, 0, sizeof(encoder));
+    for(i=0; i<0x100; i++) {
+        if(OPDESC_TEXT[i]) encode_insert(e, OPDESC_TEXT[i], i);
+        encode_insert(e, OPDESC_CB_TEXT[i], 0x100 | i);
+    }
+}
+
+/** Opcode (0x1xx for bit operations) of instruction text, -1 if unknown. */
+int encode_lookup(const encoder* e, const char* text) {
+    uint32_t i;
+    int      c;
+
+    for(i = encode_hash(text); e->table[i]; i = (i + 1) & ((1 << ENCODE_BITS) - 1)) {
+        c = e->table[i] - 1;
+        if(strcmp(c & 0x100 ? OPDESC_CB_TEXT[c & 0xFF] : OPDESC_TEXT[c], text) == 0) return c;
+    }
+    return -1;
+}
+
+/** Address of offset as seen by code, which labels resolve to. */
+uint16_t encode_logical(uint32_t off) {
+    return off < 0x4000 ? (uint16_t)off : (uint16_t)(0x4000 | (off & 0x3FFF));
+}
+
+/** Jump target must be labelled, by symbol or by flag set in labelling. */
+int encode_label(const op* o, const sops_idx* x, const syms* s, int call) {
+    const op* t = sops_get(x, o->addr);
+
+    if(!t) return 0;
+    if(s && syms_label(s, o->addr)) return 1;
+    return (t->flags & (call ? OP_FLAG_CALL_ADDR : OP_FLAG_JMP_ADDR)) != 0;
+}
+
+/** Encodes operation into out, returns length or error. */
+int encode_op(const encoder* e, const op* o, const sops_idx* x, const syms* s, uint8_t* out) {
+    char        text[40];
+    const char* p;
+    char*       t = text;
+    uint32_t    value = 0;
+    int         code, len, rel;
+
+    /* text without comment, immediate operand is replaced by # */
+    for(p = o->name; *p && !(p[0] == ' ' && p[1] == ';') && t < text + sizeof(text) - 1; p++)
+        *t++ = *p;
+    *t = 0;
+    if(strncmp(text, "DW ", 3) == 0) {
+        if(o->flags & OP_FLAG_IS_JUMP) {
+            if(!encode_label(o, x, s, 0)) return ENCODE_LABEL;
+            value = encode_logical(o->addr);
+        } else
+            value = strtoul(text + 4, NULL, 16);
+        out[0] = value & 0xFF;
+        out[1] = value >> 8;
+        return 2;
+    }
+    if((code = encode_lookup(e, text)) < 0) {
+        for(p = o->name, t = text; *p && !(p[0] == ' ' && p[1] == ';'); p++) {
+            if(*p == '$') {
+                value = strtoul(p + 1, (char**)&p, 16);
+                *t++ = '#';
+                p--;
+            } else
+                *t++ = *p;
+        }
+        *t = 0;
+        if((code = encode_lookup(e, text)) < 0) return ENCODE_UNKNOWN;
+    }
+    if(code & 0x100) {
+        out[0] = 0xCB;
+        out[1] = code & 0xFF;
+        return 2;
+    }
+
+    len = OPDESC_LEN[code];
+    out[0] = (uint8_t)code;
+    if(o->flags & OP_FLAG_IS_JUMP) {
+        if(!encode_label(o, x, s, OPDESC_FLOW[code] == OPDESC_FLOW_CALL)) return ENCODE_LABEL;
+        value = encode_logical(o->addr);
+        if(len == 2) {
+            rel = (int)value - (encode_logical(o->off) + 2);
+            if(rel < -128 || rel > 127) return ENCODE_RANGE;
+            value = (uint32_t)rel;
+        }
+    }
+    if(len > 1) out[1] = value & 0xFF;
+    if(len > 2) out[2] = (value >> 8) & 0xFF;
+    return len;
+}
+
+/** Offset of first differing byte, len if blocks are equal. */
+uint32_t encode_cmp(const uint8_t* a, const uint8_t* b, uint32_t len) {
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+    for(; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+        if(m != 0xFFFF) return i + ctz64(~m & 0xFFFF);
+    }
+#else
+    for(; i + 8 <= len; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        if(x != y) break;
+    }
+#endif
+    for(; i < len && a[i] == b[i]; i++);
+    return i;
+}
+
+/** Bytes of data from offset until end offset, as INCBIN or DB lines of sops_asm_bytes. */
+void encode_bytes(uint8_t* image, const rom* r, uint32_t from, uint32_t to) {
+    char        buff[HEX_DB_SIZE(SOPS_DB_CHUNK)];
+    const char* p;
+    uint32_t    n, len, off;
+
+    if(to > r->total) to = r->total;
+    if(from >= to) return;
+    if(!sops_db) {
+        memcpy(image + from, r->raw + from, to - from);
+        return;
+    }
+    for(; from < to; from += n) {
+        n = to - from < SOPS_DB_CHUNK ? to - from : SOPS_DB_CHUNK;
+        len = hex_db(buff, r->raw + from, n);
+        for(p = buff, off = from; p < buff + len && off < from + n; p++)
+            if(*p == '$') {
+                image[off++] = (uint8_t)strtoul(p + 1, NULL, 16);
+                p += 2;
+            }
+    }
+}
+
+/** Data from offset until end offset, fill regions as REPT blocks of sops_asm_data. */
+void encode_gap(uint8_t* image, const rom* r, uint32_t from, uint32_t to) {
+    const fill* fl;
+    uint32_t    s, e;
+    int         i = sops_fills ? fills_find(sops_fills, from) : 0;
+
+    while((fl = sops_data_fill(&i, from, to, &s, &e))) {
+        encode_bytes(image, r, from, s);
+        memset(image + s, fl->value, e - s);
+        from = e;
+    }
+    encode_bytes(image, r, from, to);
+}
+
+/** Rebuilds ROM image from operations list and compares it with ROM. */
+void encode_roundtrip(const encoder* e, const op* head, const sops_idx* x, const syms* s,
+        const rom* r, encode_result* res) {
+    uint8_t*    image;
+    uint32_t    prev = 0, size, n;
+    const op*   o;
+    int         len;
+
+    memset(res, 0, sizeof(encode_result));
+    size = (r->total + 0x7FFF) & ~0x3FFF;
+    image = (uint8_t*)mem_calloc(MEM_OUTPUT, size, 1);
+
+    for(o = head; o; o = o->next) {
+        if(o->off > prev)
+            encode_gap(image, r, prev, o->off);
+        len = encode_op(e, o, x, s, image + o->off);
+        if(len < 0) {
+            if(!res->errors++) {
+                res->error_op = o;
+                res->error = len;
+            }
+        } else
+            res->ops++;
+        prev = o->off + o->len;
+    }
+
+    /* rest of last bank, bank 1 when code ends in bank 0 */
+    if(prev % 0x4000) {
+        n = (prev / 0x4000 + 1) * 0x4000;
+        if(n == 0x4000) n = 0x8000;
+        encode_gap(image, r, prev, n < r->total ? n : r->total);
+        prev = n;
+    }
+    res->len = prev;
+
+    n = encode_cmp(image, r->raw, res->len < r->total ? res->len : r->total);
+    res->mismatch = -1;
+    if(n < res->len && n < r->total) {
+        res->mismatch = n;
+        res->expected = r->raw[n];
+        res->got = image[n];
+    } else if(res->len != r->total)
+        res->mismatch = n;
+    mem_free(image);
+}
+
+/** Prints round-trip result, returns 0 if image is identical. */
+int encode_report(const encode_result* res, const sops_idx* x, const rom* r, FILE* f) {
+    const op* o;
+
+    if(res->mismatch < 0 && !res->errors) {
+        fprintf(f, "Round-trip OK: %u instructions, %u bytes\n", res->ops, res->len);
+        return 0;
+    }
+    if(res->mismatch < 0)
+        fprintf(f, "Round-trip image is identical, %u bytes\n", res->len);
+    else if((uint32_t)res->mismatch >= res->len || (uint32_t)res->mismatch >= r->total)
+        fprintf(f, "Round-trip mismatch: rebuilt image has %u bytes, ROM has %u\n", res->len, r->total);
+    else {
+        fprintf(f, "Round-trip mismatch at 0x%.8lX: ROM $%.2X, rebuilt $%.2X",
+            res->mismatch, res->expected, res->got);
+        o = sops_get(x, res->mismatch);
+        if(!o) o = sops_prev(x, res->mismatch);
+        if(o && res->mismatch < (long)(o->off + o->len))
+            fprintf(f, " in \"%s\" at 0x%.8X", o->name, o->off);
+        fprintf(f, "\n");
+    }
+    if(res->errors)
+        fprintf(f, "%d instructions could not be encoded, first \"%s\" at 0x%.8X: %s\n",
+            res->errors, res->error_op->name, res->error_op->off, ENCODE_ERRORS[-res->error]);
+    return -1;
+}
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef __GB_DASM_EVENTS_H__
+#define __GB_DASM_EVENTS_H__
+
+/* events.h: Chrome/Perfetto trace-event spans (--trace-events).
+
+   Every thread records complete events into its own ring buffer, oldest
+   events are overwritten when it is full. Buffers are written as JSON at exit. */
+
+#include "stdinc.h"
+#include "mem.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <time.h>
+#else
+#include <time.h>
+#endif
+
+/** Events kept per thread. */
+#define EVENTS_RING     (1 << 16)
+
+/** Complete event, name is printf format taking arg when arg >= 0. */
+typedef struct event {
+    const char* name;
+    const char* cat;
+    double      ts;
+    double      dur;
+    int         arg;
+} event;
+
+typedef struct events_buf {
+    event*      ring;
+    uint32_t    head;
+    uint32_t    len;
+    uint64_t    dropped;
+    int         tid;
+    struct events_buf* next;
+} events_buf;
+
+typedef struct events {
+    int         enabled;
+    /** Start time, timestamps are microseconds since. */
+    double      t0;
+    events_buf* bufs;
+    int         threads;
+#ifndef _WIN32
+    pthread_key_t   key;
+    pthread_mutex_t lock;
+#endif
+} events;
+
+/** Monotonic time in microseconds. */
+double events_clock(void) {
+#ifdef _WIN32
+    return (double)clock() * 1e6 / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+#endif
+}
+
+void events_init(events* ev) {
+    memset(ev, 0, sizeof(events));
+    ev->enabled = 1;
+    ev->t0 = events_clock();
+#ifndef _WIN32
+    pthread_key_create(&ev->key, NULL);
+    pthread_mutex_init(&ev->lock, NULL);
+#endif
+}
+
+/** Timestamp for span start. */
+double events_now(const events* ev) {
+    return events_clock() - ev->t0;
+}
+
+/** Buffer of calling thread, created on first event. */
+events_buf* events_local(events* ev) {
+    events_buf* b;
+
+#ifndef _WIN32
+    if((b = (events_buf*)pthread_getspecific(ev->key))) return b;
+#else
+    if((b = ev->bufs)) return b;
+#endif
+    b = (events_buf*)mem_calloc(MEM_TRACE, 1, sizeof(events_buf));
+    b->ring = (event*)mem_alloc(MEM_TRACE, EVENTS_RING * sizeof(event));
+#ifndef _WIN32
+    pthread_setspecific(ev->key, b);
+    pthread_mutex_lock(&ev->lock);
+#endif
+    b->tid = ev->threads++;
+    b->next = ev->bufs;
+    ev->bufs = b;
+#ifndef _WIN32
+    pthread_mutex_unlock(&ev->lock);
+#endif
+    return b;
+}
+
+/** Span from start until now. */
+void events_span(events* ev, const char* name, const char* cat, double start, int arg) {
+    events_buf* b;
+    event*      e;
+
+    if(!ev || !ev->enabled) return;
+    b = events_local(ev);
+    e = &b->ring[b->head];
+    e->name = name;
+    e->cat = cat;
+    e->ts = start;
+    e->dur = events_now(ev) - start;
+    e->arg = arg;
+    b->head = (b->head + 1) & (EVENTS_RING - 1);
+    if(b->len < EVENTS_RING) b->len++; else b->dropped++;
+}
+
+/** Writes all buffers as trace-event JSON. */
+void events_write(const events* ev, FILE* f) {
+    events_buf* b;
+    uint64_t    dropped = 0;
+    uint32_t    i;
+    int         first = 1;
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    for(b = ev->bufs; b; b = b->next) {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+            first ? "" : ",\n", b->tid, b->tid ? "thread" : "main", b->tid);
+        first = 0;
+        for(i=0; i<b->len; i++) {
+            const event* e = &b->ring[(b->head - b->len + i) & (EVENTS_RING - 1)];
+            fprintf(f, ",\n{\"name\":\"");
+            if(e->arg >= 0) fprintf(f, e->name, e->arg); else fputs(e->name, f);
+            fprintf(f, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                e->cat, e->ts, e->dur, b->tid);
+        }
+        dropped += b->dropped;
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%llu}}\n",
+        (unsigned long long)dropped);
+}
+
+void events_free(events* ev) {
+    events_buf* b;
+
+    while((b = ev->bufs)) {
+        ev->bufs = b->next;
+        mem_free(b->ring);
+        mem_free(b);
+    }
+#ifndef _WIN32
+    if(ev->enabled) {
+        pthread_key_delete(ev->key);
+        pthread_mutex_destroy(&ev->lock);
+    }
+#endif
+    ev->enabled = 0;
+}
+
+#endif
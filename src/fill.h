@@ -0,0 +1,148 @@
+#ifndef __GB_DASM_FILL_H__
+#define __GB_DASM_FILL_H__
+
+/* fill.h: Uniform fill regions (padding) of ROM, --fill.
+
+   Run of at least 32 bytes contains whole aligned 16-byte block, so only
+   uniform aligned blocks are extended to both sides, other blocks cost one
+   compare. Regions don't cross banks, REPT can't cross sections. */
+
+#include "stdinc.h"
+#include "mem.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** Shortest fill run, smaller minimum is raised to it. */
+#define FILL_MIN    32
+
+typedef struct fill {
+    uint32_t    off;
+    uint32_t    len;
+    uint8_t     value;
+} fill;
+
+typedef struct fills {
+    fill*       list;
+    int         len;
+    int         reserved;
+    /** Bytes in regions, bit per offset. */
+    uint64_t*   map;
+    uint32_t    total;
+    uint32_t    bytes;
+    /** Shortest region. */
+    uint32_t    min;
+} fills;
+
+/** Block of 16 bytes has the same value. */
+int fill_uniform(const uint8_t* p) {
+#ifdef __SSE2__
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)p[0]))) == 0xFFFF;
+#else
+    uint64_t x, y, w = p[0] * 0x0101010101010101ULL;
+    memcpy(&x, p, 8);
+    memcpy(&y, p + 8, 8);
+    return x == w && y == w;
+#endif
+}
+
+/** Length of run of value from p, at most n. */
+uint32_t fill_run(const uint8_t* p, uint32_t n, uint8_t value) {
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+    __m128i v = _mm_set1_epi8((char)value);
+    for(; i + 16 <= n; i += 16) {
+        uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), v));
+        if(m != 0xFFFF) return i + ctz64(~m & 0xFFFF);
+    }
+#else
+    uint64_t w = value * 0x0101010101010101ULL, x;
+    for(; i + 8 <= n; i += 8) {
+        memcpy(&x, p + i, 8);
+        if(x != w) break;
+    }
+#endif
+    for(; i < n && p[i] == value; i++);
+    return i;
+}
+
+void fills_add(fills* fs, uint32_t off, uint32_t len, uint8_t value) {
+    uint32_t i;
+
+    if(fs->len == fs->reserved) {
+        fs->reserved = fs->reserved ? fs->reserved * 2 : 256;
+        fs->list = (fill*)mem_realloc(MEM_ANALYSIS, fs->list, fs->reserved * sizeof(fill));
+    }
+    fs->list[fs->len].off = off;
+    fs->list[fs->len].len = len;
+    fs->list[fs->len].value = value;
+    fs->len++;
+    fs->bytes += len;
+    for(i = off; i < off + len; i++)
+        fs->map[i >> 6] |= 1ULL << (i & 63);
+}
+
+/** Finds runs of at least min bytes, regions are sorted by offset. */
+void fills_scan(fills* fs, const uint8_t* raw, uint32_t total, uint32_t min) {
+    uint32_t    bank, lo, hi, i, s, e;
+    uint8_t     v;
+
+    memset(fs, 0, sizeof(fills));
+    fs->total = total;
+    fs->map = (uint64_t*)mem_calloc(MEM_ANALYSIS, (total >> 6) + 1, sizeof(uint64_t));
+    if(min < FILL_MIN) min = FILL_MIN;
+    fs->min = min;
+
+    for(bank = 0; bank * 0x4000 < total; bank++) {
+        lo = bank * 0x4000;
+        hi = lo + 0x4000 < total ? lo + 0x4000 : total;
+        for(i = lo; i + 16 <= hi; i += 16) {
+            if(!fill_uniform(raw + i)) continue;
+            v = raw[i];
+            /* previous region ends before this block, so s doesn't go back into it */
+            for(s = i; s > lo && raw[s-1] == v; s--);
+            e = i + 16 + fill_run(raw + i + 16, hi - i - 16, v);
+            if(e - s >= min) fills_add(fs, s, e - s, v);
+            i = ((e + 15) & ~15U) - 16;
+        }
+    }
+}
+
+/** Offset is in fill region. */
+int fills_contains(const fills* fs, uint32_t off) {
+    if(!fs->map || off >= fs->total) return 0;
+    return (fs->map[off >> 6] >> (off & 63)) & 1;
+}
+
+/** First region ending after offset, fs->len if there is none. */
+int fills_find(const fills* fs, uint32_t off) {
+    int lo = 0, hi = fs->len, mid;
+
+    while(lo < hi) {
+        mid = (lo + hi) / 2;
+        if(fs->list[mid].off + fs->list[mid].len <= off)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/** Offset is followed by at least minimum length of its fill region, code can't run there. */
+int fills_blocks(const fills* fs, uint32_t off) {
+    const fill* fl;
+
+    if(!fills_contains(fs, off)) return 0;
+    fl = &fs->list[fills_find(fs, off)];
+    return fl->off + fl->len - off >= fs->min;
+}
+
+void fills_free(fills* fs) {
+    mem_free(fs->list);
+    mem_free(fs->map);
+}
+
+#endif
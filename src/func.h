@@ -0,0 +1,314 @@
+#ifndef __GB_DASM_FUNC_H__
+#define __GB_DASM_FUNC_H__
+
+/* func.h: Functions discovery and call graph. */
+
+#include "cfg.h"
+#include "pool.h"
+
+/** Functions, numbered by entry address. Blocks, callees and callers are CSR arrays. */
+typedef struct funcs {
+    /** Number of functions. */
+    int         len;
+    /** Entry block of function. */
+    uint32_t*   entry;
+    /** Function owning block, -1 if block is not reachable from any entry. */
+    int*        owner;
+    /** Blocks of function f: blocks[block_off[f]] .. blocks[block_off[f+1]-1]. */
+    uint32_t*   block_off;
+    uint32_t*   blocks;
+    /** Called functions, including tail jumps and jumps to code owned by other function. */
+    uint32_t*   callee_off;
+    uint32_t*   callee;
+    /** Calling functions. */
+    uint32_t*   caller_off;
+    uint32_t*   caller;
+    /** Strongly connected components (recursion), callees first.
+        Members of component s: order[scc_off[s]] .. order[scc_off[s+1]-1]. */
+    int         scc_len;
+    uint32_t*   scc;
+    uint32_t*   scc_off;
+    uint32_t*   order;
+    /** Call depth, computed bottom-up, -1 for recursive functions. */
+    int*        depth;
+} funcs;
+
+/** Per function analysis, run after analyses of all its callees. */
+typedef void (*func_pass)(funcs* fs, const cfg* g, int f, void* ctx);
+
+/** Function entered at block b, -1 if b is not an entry. */
+int func_at(const funcs* fs, int b) {
+    int lo = 0, hi = fs->len - 1;
+
+    while(lo <= hi) {
+        int mid = (lo + hi) >> 1;
+        if(fs->entry[mid] == (uint32_t)b) return mid;
+        if(fs->entry[mid] < (uint32_t)b) lo = mid + 1; else hi = mid - 1;
+    }
+    return -1;
+}
+
+/** Tarjan's algorithm, iterative, components come out callees first. */
+void func_scc(funcs* fs) {
+    int*        index;
+    int*        low;
+    uint32_t*   stack;
+    uint32_t*   call;
+    uint32_t*   edge;
+    uint8_t*    on;
+    int         counter = 0, sp = 0, cp = 0, n = 0;
+    int         root, f, g;
+
+    index = (int*)mem_alloc(MEM_ANALYSIS, fs->len * sizeof(int));
+    low = (int*)mem_alloc(MEM_ANALYSIS, fs->len * sizeof(int));
+    stack = (uint32_t*)mem_alloc(MEM_ANALYSIS, fs->len * sizeof(uint32_t));
+    call = (uint32_t*)mem_alloc(MEM_ANALYSIS, fs->len * sizeof(uint32_t));
+    edge = (uint32_t*)mem_alloc(MEM_ANALYSIS, fs->len * sizeof(uint32_t));
+    on = (uint8_t*)mem_calloc(MEM_ANALYSIS, fs->len, 1);
+    fs->scc = (uint32_t*)mem_alloc(MEM_ANALYSIS, fs->len * sizeof(uint32_t));
+    fs->scc_off = (uint32_t*)mem_alloc(MEM_ANALYSIS, (fs->len + 1) * sizeof(uint32_t));
+    fs->order = (uint32_t*)mem_alloc(MEM_ANALYSIS, fs->len * sizeof(uint32_t));
+    fs->scc_len = 0;
+    for(f=0; f<fs->len; f++) index[f] = -1;
+
+    for(root=0; root<fs->len; root++) {
+        if(index[root] >= 0) continue;
+        index[root] = low[root] = counter++;
+        stack[sp++] = root; on[root] = 1;
+        call[cp] = root; edge[cp++] = fs->callee_off[root];
+        while(cp) {
+            f = call[cp-1];
+            if(edge[cp-1] < fs->callee_off[f+1]) {
+                g = fs->callee[edge[cp-1]++];
+                if(index[g] < 0) {
+                    index[g] = low[g] = counter++;
+                    stack[sp++] = g; on[g] = 1;
+                    call[cp] = g; edge[cp++] = fs->callee_off[g];
+                } else if(on[g] && index[g] < low[f])
+                    low[f] = index[g];
+                continue;
+            }
+            /* all callees visited */
+            cp--;
+            if(cp && low[f] < low[call[cp-1]]) low[call[cp-1]] = low[f];
+            if(low[f] == index[f]) {
+                fs->scc_off[fs->scc_len] = n;
+                do {
+                    g = stack[--sp];
+                    on[g] = 0;
+                    fs->scc[g] = fs->scc_len;
+                    fs->order[n++] = g;
+                } while(g != f);
+                fs->scc_len++;
+            }
+        }
+    }
+    fs->scc_off[fs->scc_len] = n;
+
+    mem_free(index); mem_free(low); mem_free(stack); mem_free(call); mem_free(edge); mem_free(on);
+}
+
+/** Discovers functions from call and RST destinations plus the start block. */
+funcs* func_build(const cfg* g, uint32_t start) {
+    funcs*      fs;
+    uint32_t*   queue;
+    int*        seen;
+    uint32_t    e, n;
+    int         b, f, c, head, tail;
+
+    fs = (funcs*)mem_calloc(MEM_ANALYSIS, 1, sizeof(funcs));
+    fs->owner = (int*)mem_alloc(MEM_ANALYSIS, g->len * sizeof(int));
+    for(b=0; b<g->len; b++) fs->owner[b] = -1;
+
+    /* entries, marked in owner for now and collected in address order */
+    if((b = cfg_block(g, start)) >= 0) fs->owner[b] = 0;
+    for(e=0; e<(uint32_t)g->edges; e++)
+        if(g->edge_kind[e] == CFG_EDGE_CALL) fs->owner[g->edge_dst[e]] = 0;
+    fs->entry = (uint32_t*)mem_alloc(MEM_ANALYSIS, (g->len + 1) * sizeof(uint32_t));
+    for(b=0; b<g->len; b++)
+        if(fs->owner[b] == 0) {
+            fs->owner[b] = fs->len;
+            fs->entry[fs->len++] = b;
+        }
+
+    /* extents, every block belongs to the first function reaching it */
+    queue = (uint32_t*)mem_alloc(MEM_ANALYSIS, (g->len + 1) * sizeof(uint32_t));
+    fs->block_off = (uint32_t*)mem_alloc(MEM_ANALYSIS, (fs->len + 1) * sizeof(uint32_t));
+    fs->blocks = queue;
+    for(f=0, tail=0; f<fs->len; f++) {
+        fs->block_off[f] = head = tail;
+        queue[tail++] = fs->entry[f];
+        while(head < tail) {
+            b = queue[head++];
+            for(e = g->edge_off[b]; e < g->edge_off[b+1]; e++) {
+                int d = g->edge_dst[e];
+                if(g->edge_kind[e] == CFG_EDGE_CALL || fs->owner[d] >= 0) continue;
+                fs->owner[d] = f;
+                queue[tail++] = d;
+            }
+        }
+    }
+    fs->block_off[fs->len] = tail;
+
+    /* call graph, calls plus control flow leaving function */
+    seen = (int*)mem_alloc(MEM_ANALYSIS, (fs->len + 1) * sizeof(int));
+    for(f=0; f<fs->len; f++) seen[f] = -1;
+    fs->callee_off = (uint32_t*)mem_alloc(MEM_ANALYSIS, (fs->len + 1) * sizeof(uint32_t));
+    fs->callee = (uint32_t*)mem_alloc(MEM_ANALYSIS, (g->edges + 1) * sizeof(uint32_t));
+    for(f=0, n=0; f<fs->len; f++) {
+        fs->callee_off[f] = n;
+        for(c = fs->block_off[f]; c < (int)fs->block_off[f+1]; c++) {
+            b = fs->blocks[c];
+            for(e = g->edge_off[b]; e < g->edge_off[b+1]; e++) {
+                int d = fs->owner[g->edge_dst[e]];
+                if(d < 0 || (d == f && g->edge_kind[e] != CFG_EDGE_CALL)) continue;
+                if(seen[d] == f) continue;
+                seen[d] = f;
+                fs->callee[n++] = d;
+            }
+        }
+    }
+    fs->callee_off[fs->len] = n;
+
+    /* callers, reversed callees */
+    fs->caller_off = (uint32_t*)mem_calloc(MEM_ANALYSIS, fs->len + 1, sizeof(uint32_t));
+    fs->caller = (uint32_t*)mem_alloc(MEM_ANALYSIS, (n + 1) * sizeof(uint32_t));
+    for(e=0; e<n; e++) fs->caller_off[fs->callee[e] + 1]++;
+    for(f=0; f<fs->len; f++) fs->caller_off[f+1] += fs->caller_off[f];
+    for(f=0; f<fs->len; f++) seen[f] = fs->caller_off[f];
+    for(f=0; f<fs->len; f++)
+        for(e = fs->callee_off[f]; e < fs->callee_off[f+1]; e++)
+            fs->caller[seen[fs->callee[e]]++] = f;
+    mem_free(seen);
+
+    func_scc(fs);
+    fs->depth = (int*)mem_alloc(MEM_ANALYSIS, (fs->len + 1) * sizeof(int));
+    return fs;
+}
+
+void func_free(funcs* fs) {
+    if(!fs) return;
+    mem_free(fs->entry);
+    mem_free(fs->owner);
+    mem_free(fs->block_off);
+    mem_free(fs->blocks);
+    mem_free(fs->callee_off);
+    mem_free(fs->callee);
+    mem_free(fs->caller_off);
+    mem_free(fs->caller);
+    mem_free(fs->scc);
+    mem_free(fs->scc_off);
+    mem_free(fs->order);
+    mem_free(fs->depth);
+    mem_free(fs);
+}
+
+/** Bottom-up scheduling state. */
+typedef struct func_sched {
+    funcs*      fs;
+    const cfg*  g;
+    func_pass   pass;
+    void*       ctx;
+    pool*       p;
+    /** Calls from component to components not done yet. */
+    int*        pending;
+    /** Task argument per component. */
+    struct func_job* jobs;
+} func_sched;
+
+typedef struct func_job {
+    func_sched* sched;
+    int         scc;
+} func_job;
+
+void func_task(void* arg) {
+    func_job*   job = (func_job*)arg;
+    func_sched* s = job->sched;
+    funcs*      fs = s->fs;
+    uint32_t    i, e;
+
+    /* recursive functions in component run sequentially */
+    for(i = fs->scc_off[job->scc]; i < fs->scc_off[job->scc+1]; i++) {
+        int f = fs->order[i];
+        double t0 = s->p->trace ? events_now(s->p->trace) : 0;
+        s->pass(fs, s->g, f, s->ctx);
+        if(s->p->trace) events_span(s->p->trace, "func %05X", "analysis", t0, (int)s->g->start[fs->entry[f]]);
+    }
+
+    /* callers whose callees are all done become ready */
+    for(i = fs->scc_off[job->scc]; i < fs->scc_off[job->scc+1]; i++) {
+        int f = fs->order[i];
+        for(e = fs->caller_off[f]; e < fs->caller_off[f+1]; e++) {
+            int c = fs->scc[fs->caller[e]];
+            if(c != job->scc && pool_dec(&s->pending[c]) == 0)
+                pool_submit(s->p, func_task, &s->jobs[c]);
+        }
+    }
+}
+
+/** Runs pass over every function, callees before callers, in parallel where possible.
+    Spans per function and task are recorded to ev, if not NULL. */
+void func_bottom_up(funcs* fs, const cfg* g, func_pass pass, void* ctx, int threads, events* ev) {
+    func_sched  s;
+    uint32_t    e;
+    int         f, c;
+
+    s.fs = fs;
+    s.g = g;
+    s.pass = pass;
+    s.ctx = ctx;
+    s.pending = (int*)mem_calloc(MEM_ANALYSIS, fs->scc_len + 1, sizeof(int));
+    s.jobs = (func_job*)mem_alloc(MEM_ANALYSIS, (fs->scc_len + 1) * sizeof(func_job));
+    for(f=0; f<fs->len; f++)
+        for(e = fs->callee_off[f]; e < fs->callee_off[f+1]; e++)
+            if(fs->scc[fs->callee[e]] != fs->scc[f]) s.pending[fs->scc[f]]++;
+
+    /* pool is created after pending counts, leaves are submitted in order */
+    s.p = pool_create(threads);
+    s.p->trace = ev;
+    for(c=0; c<fs->scc_len; c++) {
+        s.jobs[c].sched = &s;
+        s.jobs[c].scc = c;
+    }
+    for(c=0; c<fs->scc_len; c++)
+        if(s.pending[c] == 0) pool_submit(s.p, func_task, &s.jobs[c]);
+    pool_wait(s.p);
+    pool_free(s.p);
+
+    mem_free(s.pending);
+    mem_free(s.jobs);
+}
+
+/** Call depth pass, leaf functions have depth 0. */
+void func_depth_pass(funcs* fs, const cfg* g, int f, void* ctx) {
+    uint32_t    e;
+    int         d = 0;
+
+    for(e = fs->callee_off[f]; e < fs->callee_off[f+1]; e++) {
+        int c = fs->callee[e];
+        if(fs->scc[c] == fs->scc[f] || fs->depth[c] < 0) {
+            d = -1;
+            break;
+        }
+        if(fs->depth[c] + 1 > d) d = fs->depth[c] + 1;
+    }
+    fs->depth[f] = d;
+}
+
+/** Functions list. */
+void func_dump(const funcs* fs, const cfg* g, FILE* f) {
+    uint32_t    i;
+    int         n, size;
+
+    for(n=0; n<fs->len; n++) {
+        for(i = fs->block_off[n], size = 0; i < fs->block_off[n+1]; i++)
+            size += g->end[fs->blocks[i]] - g->start[fs->blocks[i]];
+        fprintf(f, "[0x%.8X] sub_%x blocks=%u size=%d callers=%u callees=%u depth=%d\n",
+            g->start[fs->entry[n]], g->start[fs->entry[n]],
+            fs->block_off[n+1] - fs->block_off[n], size,
+            fs->caller_off[n+1] - fs->caller_off[n],
+            fs->callee_off[n+1] - fs->callee_off[n], fs->depth[n]);
+    }
+}
+
+#endif
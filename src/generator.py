@@ -2,6 +2,7 @@
 # Generater code from opcodes from http://pastraiser.com/cpu/gameboy/gameboy_opcodes.html
 
 import re
+import sys
 from HTMLParser import HTMLParser
 
 f = open('./src/opcodes.html', 'r')
@@ -39,6 +40,76 @@ class MyHTMLParser(HTMLParser):
 parser = MyHTMLParser()
 parser.feed(lines)
 
+# 'desc' argument generates opcodes descriptor tables instead of the big switch
+if len(sys.argv) > 1 and sys.argv[1] == 'desc':
+    print '/* AUTOGENERATED - look at generator.py */'
+    print '#ifndef __GB_DASM_OPDESC_H__'
+    print '#define __GB_DASM_OPDESC_H__'
+    print ''
+    print '/** Instruction length in bytes, 0 for unused opcodes. */'
+    print 'static const uint8_t OPDESC_LEN[0x100] = {'
+    for i in range(0, 0x100, 0x10):
+        row = []
+        for j in range(i, i+0x10):
+            op = parser.out[j+0x10]
+            row.append(op[1] if len(op) else '0')
+        print '    ' + ', '.join(row) + ','
+    print '};'
+    print ''
+    print '/* Control flow classes. */'
+    print '#define OPDESC_FLOW_NONE    0'
+    print '#define OPDESC_FLOW_JUMP    1 /* unconditional jump */'
+    print '#define OPDESC_FLOW_BRANCH  2 /* conditional jump */'
+    print '#define OPDESC_FLOW_CALL    3 /* conditional or unconditional call */'
+    print '#define OPDESC_FLOW_RET     4 /* unconditional return */'
+    print '#define OPDESC_FLOW_RETCC   5 /* conditional return */'
+    print '#define OPDESC_FLOW_RST     6 /* restart, call to vector */'
+    print '#define OPDESC_FLOW_JPHL    7 /* indirect jump */'
+    print ''
+    print '/** Instruction control flow class. */'
+    print 'static const uint8_t OPDESC_FLOW[0x100] = {'
+    for i in range(0, 0x100, 0x10):
+        row = []
+        for j in range(i, i+0x10):
+            op = parser.out[j+0x10]
+            name = op[0] if len(op) else ''
+            if j == 0xe9:
+                row.append('7')
+            elif name.startswith('RST'):
+                row.append('6')
+            elif name.startswith('RETI') or name == 'RET':
+                row.append('4')
+            elif name.startswith('RET '):
+                row.append('5')
+            elif name.startswith('CALL'):
+                row.append('3')
+            elif name.startswith('JP ') or name.startswith('JR '):
+                row.append('2' if ',' in name else '1')
+            else:
+                row.append('0')
+        print '    ' + ', '.join(row) + ','
+    print '};'
+    print ''
+    print '/** Instruction text, immediate operand replaced by #, NULL for unused opcodes. */'
+    print 'static const char* OPDESC_TEXT[0x100] = {'
+    for i in range(0, 0x100, 4):
+        row = []
+        for j in range(i, i+4):
+            op = parser.out[j+0x10]
+            row.append('"%s"' % re.sub('[dar](8|16)', '#', op[0]) if len(op) and j != 0xcb else 'NULL')
+        print '    ' + ', '.join(row) + ','
+    print '};'
+    print ''
+    print '/** Bit operations text, after 0xCB prefix. */'
+    print 'static const char* OPDESC_CB_TEXT[0x100] = {'
+    for i in range(0, 0x100, 4):
+        print '    ' + ', '.join(['"%s"' % parser.out[j+0x120][0] for j in range(i, i+4)]) + ','
+    print '};'
+    print ''
+    print '#endif'
+    print '/* AUTOGENERATED - end */'
+    sys.exit(0)
+
 # variables
 VARS = ['d8', 'd16', 'a8', 'a16', 'r8']
 # additional operations for specified functions, bank change emulation
@@ -46,11 +117,33 @@ spec = {
     0x3e: '\ta = addr8;',
     0xea: '\tif(mbc != ROM_ONLY && (addr16 == 0x2000 || addr16 == 0x2100)) {\n'
         + '\t\tprintf("Info: Bank switch to %d at 0x%.8X\\n", bank, phy(pc));\n'
-        + '\t\tbank = a;\n\t}', 
+        + '\t\tbank = a;\n\t\trun_stats.bank_switches++;\n\t}', 
+    0x21: '\thl = addr16;\n\thl_valid = 1;',
     0xe0: '\thmem[addr8] = a;', 
     0xf0: '\ta = hmem[addr8];',
     0x76: '\tprintf("Warning: RGBASM could not handle HALT instruction properly (0x%.8X)\\n", phy(pc));'
 }
+# writers of H or L other than LD HL,d16 and index ADD HL,rr, jump table base in hl is kept
+# only inside table load tails of jtab.h
+def hl_writer(name):
+    return (re.match(r'(LD|INC|DEC|POP) (H|L|HL)(,|$)', name) and name != 'LD HL,d16') or \
+        '[HLI]' in name or '[HLD]' in name
+def hl_writer_cb(name):
+    return not name.startswith('BIT') and (name.endswith(' H') or name.endswith(',H') or
+        name.endswith(' L') or name.endswith(',L'))
+
+# data cross references, address operand and kind
+xref = {
+    0x01: ('addr16', 'XREF_PTR'),
+    0x08: ('addr16', 'XREF_WRITE'),
+    0x11: ('addr16', 'XREF_PTR'),
+    0x21: ('addr16', 'XREF_PTR'),
+    0x31: ('addr16', 'XREF_PTR'),
+    0xe0: ('0xFF00 | addr8', 'XREF_WRITE'),
+    0xea: ('addr16', 'XREF_WRITE'),
+    0xf0: ('0xFF00 | addr8', 'XREF_READ'),
+    0xfa: ('addr16', 'XREF_READ')
+}
     
 print '/* AUTOGENERATED - look at generator.py */'
 for i in range(0, 0x100):
@@ -65,7 +158,9 @@ for i in range(0, 0x100):
             op2 = parser.out[j+0x120][0]
             print '\t/* %s */' % op2
             print '\tcase ' + hex(j) + ':'
-            print '\t\tsops = sops_add(sops, op_0_2("%s"));' % op2
+            print '\t\tsops = sops_add(sops, &ops_index, op_0_2("%s"));' % op2
+            if hl_writer_cb(op2):
+                print '\t\thl_write();'
             print '\t\tbreak;'
         print '\t}'
         print '\tpc += 2;'
@@ -76,30 +171,30 @@ for i in range(0, 0x100):
     print 'case ' + hex(i) + ':'
     if(op[1] == '1'): # 1-byte ops
         name = op[0]
-        print '\tsops = sops_add(sops, op_0("%s"));' % name
+        print '\tsops = sops_add(sops, &ops_index, op_0("%s"));' % name
     elif(op[1] == '2'): # 2-byte ops
         print '\taddr8 = r->raw[phy(pc+1)];'
         for var in VARS:
             bvar = '(' + var + ')'
             if op[0].endswith(var):
                 name = op[0][0:len(op[0])-len(var)]
-                print '\tsops = sops_add(sops, op_r8("%s", addr8));' % name
+                print '\tsops = sops_add(sops, &ops_index, op_r8("%s", addr8));' % name
                 break
             elif op[0].endswith(bvar):
                 name = op[0][0:len(op[0])-len(bvar)]
-                print '\tsops = sops_add(sops, op_rb8("%s", addr8));' % name
+                print '\tsops = sops_add(sops, &ops_index, op_rb8("%s", addr8));' % name
                 break
             elif bvar in op[0]:
                 where = op[0].find(bvar)
                 name = op[0][0:where].strip()
                 r = op[0][where+len(bvar):].strip()
-                print '\tsops = sops_add(sops, op_lb8("%s", addr8, "%s"));' % (name, r)
+                print '\tsops = sops_add(sops, &ops_index, op_lb8("%s", addr8, "%s"));' % (name, r)
                 break
             elif var in op[0]:
                 where = op[0].find(var)
                 name = op[0][0:where].strip()
                 r = op[0][where+len(var):].strip()
-                print '\tsops = sops_add(sops, op_l8("%s", addr8, "%s"));' % (name, r)
+                print '\tsops = sops_add(sops, &ops_index, op_l8("%s", addr8, "%s"));' % (name, r)
                 break
     elif(op[1] == '3'): # 3-byte ops
         print '\taddr16 = r->raw[phy(pc+1)] | (r->raw[phy(pc+2)]<<8);'
@@ -107,34 +202,40 @@ for i in range(0, 0x100):
             bvar = '(' + var + ')'
             if op[0].endswith(var):
                 name = op[0][0:len(op[0])-len(var)]
-                print '\tsops = sops_add(sops, op_r16("%s", addr16));' % name
+                print '\tsops = sops_add(sops, &ops_index, op_r16("%s", addr16));' % name
                 break
             elif op[0].endswith(bvar):
                 name = op[0][0:len(op[0])-len(bvar)]
-                print '\tsops = sops_add(sops, op_rb16("%s", addr16));' % name
+                print '\tsops = sops_add(sops, &ops_index, op_rb16("%s", addr16));' % name
                 break
             elif bvar in op[0]:
                 where = op[0].find(bvar)
                 name = op[0][0:where].strip()
                 r = op[0][where+len(bvar):].strip()
-                print '\tsops = sops_add(sops, op_lb16("%s", addr16, "%s"));' % (name, r)
+                print '\tsops = sops_add(sops, &ops_index, op_lb16("%s", addr16, "%s"));' % (name, r)
                 break
             elif var in op[0]:
                 where = op[0].find(var)
                 name = op[0][0:where].strip()
                 r = op[0][where+len(var):].strip()
-                print '\tsops = sops_add(sops, op_l16("%s", addr16, "%s"));' % (name, r)
+                print '\tsops = sops_add(sops, &ops_index, op_l16("%s", addr16, "%s"));' % (name, r)
                 break
     else:
         raise Exception('Wrong operator length')
         
     if i in spec:
         print spec[i]
+    if i in xref:
+        print '\txrefs_add(&data_refs, %s, phy(pc), %s);' % xref[i]
+    if hl_writer(op[0]):
+        print '\thl_write();'
     
     # jumps/call handling
     name = name.strip()
-    if i == 0xe9: # skip JP (HL)
-        print '\tpc += ' + op[1] + ';'
+    if i == 0xe9: # JP (HL), followed only through recognized jump tables
+        print '\tjmp_hl();'
+    elif name.startswith('RST'): # RST to jump table dispatcher
+        print '\trst(0x%x);' % (i & 0x38)
     elif name.startswith('CALL'): # conditional jumps/calls
         print '\taddr_buff_add(&call_addr, phy(addr16));'
         print '\tif(call_follow) jmp16(addr16); else pc += ' + op[1] +';'
@@ -0,0 +1,100 @@
+#ifndef __GB_DASM_HEX_H__
+#define __GB_DASM_HEX_H__
+
+/* hex.h: Bytes as DB lines of hex values, --data-as-db.
+
+   Line is "\tDB $xx,$xx,...,$xx\n" with 16 values, last line of block can be
+   shorter. Full lines are formatted with SSSE3 byte shuffles where CPU has it
+   (checked at run time with GCC and clang), by 2 characters table otherwise. */
+
+#include "stdinc.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEX_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#define HEX_LINE_BYTES  16
+
+/** Characters of n bytes as DB lines. */
+#define HEX_DB_SIZE(n)  ((((n) + HEX_LINE_BYTES - 1) / HEX_LINE_BYTES) * 4 + (n) * 4)
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+/** Line prefix and values of up to 16 bytes, returns characters written. */
+uint32_t hex_db_line_scalar(char* out, const uint8_t* p, uint32_t n) {
+    uint32_t i;
+
+    memcpy(out, "\tDB ", 4);
+    out += 4;
+    for(i=0; i<n; i++, out += 4) {
+        out[0] = '$';
+        out[1] = HEX_DIGITS[p[i] >> 4];
+        out[2] = HEX_DIGITS[p[i] & 0xF];
+        out[3] = ',';
+    }
+    out[-1] = '\n';
+    return 4 + n * 4;
+}
+
+uint32_t hex_db_scalar(char* out, const uint8_t* p, uint32_t n) {
+    uint32_t i, len = 0;
+
+    for(i=0; i<n; i += HEX_LINE_BYTES)
+        len += hex_db_line_scalar(out + len, p + i, n - i < HEX_LINE_BYTES ? n - i : HEX_LINE_BYTES);
+    return len;
+}
+
+#ifdef HEX_SSSE3
+/** Full lines, nibbles are looked up in digits with pshufb, then every 4 bytes are spread
+    into "$hl,$hl,$hl,$hl," by shuffles of high and low digits or-ed into the pattern. */
+__attribute__((target("ssse3")))
+uint32_t hex_db_ssse3(char* out, const uint8_t* p, uint32_t n) {
+    const __m128i digits = _mm_loadu_si128((const __m128i*)HEX_DIGITS);
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i pattern = _mm_setr_epi8('$', 0, 0, ',', '$', 0, 0, ',', '$', 0, 0, ',', '$', 0, 0, ',');
+    __m128i       hi_at[4], lo_at[4];
+    __m128i       v, hi, lo;
+    uint32_t      i, k, len = 0;
+
+    for(k=0; k<4; k++) {
+        /* output byte 4j+1 takes high digit of input byte 4k+j, 4j+2 the low one */
+        char h[16], l[16];
+        int  j;
+        memset(h, (char)0x80, 16);
+        memset(l, (char)0x80, 16);
+        for(j=0; j<4; j++) {
+            h[4*j+1] = (char)(4*k + j);
+            l[4*j+2] = (char)(4*k + j);
+        }
+        hi_at[k] = _mm_loadu_si128((const __m128i*)h);
+        lo_at[k] = _mm_loadu_si128((const __m128i*)l);
+    }
+
+    for(i=0; i + HEX_LINE_BYTES <= n; i += HEX_LINE_BYTES) {
+        v = _mm_loadu_si128((const __m128i*)(p + i));
+        hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, mask));
+        memcpy(out + len, "\tDB ", 4);
+        for(k=0; k<4; k++)
+            _mm_storeu_si128((__m128i*)(out + len + 4 + 16*k), _mm_or_si128(pattern,
+                _mm_or_si128(_mm_shuffle_epi8(hi, hi_at[k]), _mm_shuffle_epi8(lo, lo_at[k]))));
+        len += 4 + HEX_LINE_BYTES * 4;
+        out[len - 1] = '\n';
+    }
+    if(i < n)
+        len += hex_db_line_scalar(out + len, p + i, n - i);
+    return len;
+}
+#endif
+
+/** Formats n bytes as DB lines into out, which has HEX_DB_SIZE(n) characters.
+    Returns characters written. */
+uint32_t hex_db(char* out, const uint8_t* p, uint32_t n) {
+#ifdef HEX_SSSE3
+    if(__builtin_cpu_supports("ssse3")) return hex_db_ssse3(out, p, n);
+#endif
+    return hex_db_scalar(out, p, n);
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef __GB_DASM_HISTO_H__
+#define __GB_DASM_HISTO_H__
+
+/* histo.h: Static opcode, bit operation and control flow histograms of reached
+   code, raw byte values histogram per bank. */
+
+#include "sops.h"
+#include "opdesc.h"
+
+static const char* HISTO_FLOW_NAMES[8] = {
+    "none", "jump", "branch", "call", "ret", "retcc", "rst", "jphl"
+};
+
+typedef struct histo {
+    uint64_t    op[0x100];
+    uint64_t    cb[0x100];
+    uint64_t    flow[8];
+    /** Data words on operations list, not counted as instructions. */
+    uint64_t    data;
+    /** Byte values per 16 KB bank. */
+    uint32_t    banks;
+    uint32_t*   bytes;
+} histo;
+
+/** Adds byte values to counts, four tables so repeated values don't wait on each other. */
+void histo_count(const uint8_t* p, uint32_t n, uint32_t* counts) {
+    uint32_t    c[4][0x100];
+    uint64_t    w;
+    uint32_t    i, j;
+
+    memset(c, 0, sizeof(c));
+    for(i=0; i + 8 <= n; i += 8) {
+        memcpy(&w, p + i, 8);
+        c[0][w & 0xFF]++;
+        c[1][(w >> 8) & 0xFF]++;
+        c[2][(w >> 16) & 0xFF]++;
+        c[3][(w >> 24) & 0xFF]++;
+        c[0][(w >> 32) & 0xFF]++;
+        c[1][(w >> 40) & 0xFF]++;
+        c[2][(w >> 48) & 0xFF]++;
+        c[3][w >> 56]++;
+    }
+    for(; i < n; i++) c[0][p[i]]++;
+    for(j=0; j<0x100; j++)
+        counts[j] += c[0][j] + c[1][j] + c[2][j] + c[3][j];
+}
+
+void histo_build(histo* h, const op* head, const rom* r) {
+    const op*   o;
+    uint32_t    b, n;
+
+    memset(h, 0, sizeof(histo));
+    for(o = head; o; o = o->next) {
+        if(o->flags & OP_FLAG_IS_DATA) {
+            h->data++;
+            continue;
+        }
+        if(o->code[0] == 0xCB)
+            h->cb[o->code[1]]++;
+        else
+            h->op[o->code[0]]++;
+        h->flow[OPDESC_FLOW[o->code[0]]]++;
+    }
+
+    h->banks = (r->total + 0x3FFF) / 0x4000;
+    h->bytes = (uint32_t*)mem_calloc(MEM_ANALYSIS, h->banks * 0x100, sizeof(uint32_t));
+    for(b=0; b<h->banks; b++) {
+        n = r->total - b * 0x4000 < 0x4000 ? r->total - b * 0x4000 : 0x4000;
+        histo_count(r->raw + b * 0x4000, n, h->bytes + b * 0x100);
+    }
+}
+
+void histo_print(const histo* h, FILE* f) {
+    uint64_t    total = 0;
+    uint32_t    i, b;
+
+    for(i=0; i<0x100; i++) total += h->op[i] + h->cb[i];
+    fprintf(f, "Opcodes:\n");
+    for(i=0; i<0x100; i++)
+        if(h->op[i])
+            fprintf(f, "  %.2X %-14s %10llu %6.2f%%\n", i, OPDESC_TEXT[i] ? OPDESC_TEXT[i] : "-",
+                (unsigned long long)h->op[i], 100.0 * h->op[i] / total);
+    fprintf(f, "Bit operations:\n");
+    for(i=0; i<0x100; i++)
+        if(h->cb[i])
+            fprintf(f, "  CB %.2X %-11s %10llu %6.2f%%\n", i, OPDESC_CB_TEXT[i],
+                (unsigned long long)h->cb[i], 100.0 * h->cb[i] / total);
+    fprintf(f, "Control flow:\n");
+    for(i=0; i<8; i++)
+        fprintf(f, "  %-17s %10llu %6.2f%%\n", HISTO_FLOW_NAMES[i], (unsigned long long)h->flow[i],
+            total ? 100.0 * h->flow[i] / total : 0.0);
+    fprintf(f, "  %-17s %10llu\n", "data words", (unsigned long long)h->data);
+    fprintf(f, "Bytes per bank (values 00-FF):\n");
+    for(b=0; b<h->banks; b++) {
+        fprintf(f, "  %.2X:", b);
+        for(i=0; i<0x100; i++)
+            fprintf(f, " %u", h->bytes[b * 0x100 + i]);
+        fprintf(f, "\n");
+    }
+}
+
+void histo_free(histo* h) {
+    mem_free(h->bytes);
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef __GB_DASM_JTAB_H__
+#define __GB_DASM_JTAB_H__
+
+/* jtab.h: Jump table idioms recognition. */
+
+#include "stdinc.h"
+#include "opdesc.h"
+
+/** Maximum number of entries followed in a single jump table. */
+#define JTAB_MAX_ENTRIES    256
+/** Maximum number of bytes scanned for RST dispatcher. */
+#define JTAB_SCAN_LEN       32
+
+/** Code loading HL from table entry pointed by HL, it precedes JP [HL]. */
+typedef struct jtab_tail {
+    uint8_t     len;
+    uint8_t     code[5];
+} jtab_tail;
+
+static const jtab_tail JTAB_TAILS[] = {
+    /* LD A,[HL+]; LD H,[HL]; LD L,A */
+    { 3, { 0x2A, 0x66, 0x6F } },
+    /* LD E,[HL]; INC HL; LD D,[HL]; LD H,D; LD L,E */
+    { 5, { 0x5E, 0x23, 0x56, 0x62, 0x6B } },
+    /* LD E,[HL]; INC HL; LD D,[HL]; LD L,E; LD H,D */
+    { 5, { 0x5E, 0x23, 0x56, 0x6B, 0x62 } },
+    /* LD E,[HL]; INC HL; LD D,[HL]; PUSH DE; POP HL */
+    { 5, { 0x5E, 0x23, 0x56, 0xD5, 0xE1 } },
+    /* LD C,[HL]; INC HL; LD B,[HL]; LD H,B; LD L,C */
+    { 5, { 0x4E, 0x23, 0x46, 0x60, 0x69 } },
+    /* LD C,[HL]; INC HL; LD B,[HL]; PUSH BC; POP HL */
+    { 5, { 0x4E, 0x23, 0x46, 0xC5, 0xE1 } }
+};
+
+#define JTAB_TAILS_NUM  (sizeof(JTAB_TAILS) / sizeof(JTAB_TAILS[0]))
+
+/** Check if JP [HL] at off is preceded by table entry load, lo is the lowest offset of the region. */
+int jtab_tail_match(const uint8_t* raw, uint32_t off, uint32_t lo) {
+    int i;
+
+    for(i=0; i<JTAB_TAILS_NUM; i++) {
+        const jtab_tail* t = &JTAB_TAILS[i];
+        if(off - lo >= t->len && memcmp(&raw[off - t->len], t->code, t->len) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+/** Instruction at off is part of table entry load followed by JP [HL], lo and hi bound
+    the region. Tail instructions are one byte long. */
+int jtab_in_tail(const uint8_t* raw, uint32_t off, uint32_t lo, uint32_t hi) {
+    uint32_t    s;
+    int         i, k;
+
+    for(i=0; i<JTAB_TAILS_NUM; i++) {
+        const jtab_tail* t = &JTAB_TAILS[i];
+        for(k=0; k<t->len; k++) {
+            if(t->code[k] != raw[off] || off - lo < (uint32_t)k) continue;
+            s = off - k;
+            if(s + t->len < hi && raw[s + t->len] == 0xE9 && memcmp(&raw[s], t->code, t->len) == 0)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+/** Check if RST vector pops return address to HL and jumps to it,
+    so the jump table follows RST instruction. */
+int jtab_rst_dispatcher(const uint8_t* raw, uint32_t total, uint32_t vec) {
+    uint32_t    off;
+    uint8_t     len;
+    int         pop_hl = 0;
+    int         jumped = 0;
+
+    off = vec;
+    while(off < total && off < vec + JTAB_SCAN_LEN) {
+        len = OPDESC_LEN[raw[off]];
+        if(len == 0) return 0;
+        switch(raw[off]) {
+            case 0xE1: /* POP HL */
+                pop_hl = 1; break;
+            case 0xE9: /* JP [HL] */
+                return pop_hl;
+            case 0xC3: /* JP a16, vectors are too short so follow it once */
+                if(jumped || off + 2 >= total) return 0;
+                jumped = 1;
+                vec = off = raw[off+1] | (raw[off+2]<<8);
+                if(off >= 0x4000) return 0;
+                continue;
+            case 0x18: /* JR */
+            case 0xC9: /* RET */
+            case 0xD9: /* RETI */
+                return 0;
+        }
+        off += len;
+    }
+    return 0;
+}
+
+#endif
@@ -4,6 +4,17 @@
 #include "state.h"
 #include "addr_buff.h"
 #include "io.h"
+#include "jtab.h"
+#include "func.h"
+#include "xref.h"
+#include "trace.h"
+#include "stats.h"
+#include "encode.h"
+#include "histo.h"
+#include "emit.h"
+#include "split.h"
+#include "emitter.h"
+#include "classify.h"
 
 /*
     $FFFF           Interrupt Enable Flag
@@ -43,6 +54,8 @@ char        tmp[128];
 int         bank;
 /** Program counter. */
 uint16_t    pc;
+/** pc was set by jump, call, return or restart, not moved past the decoded instruction. */
+int         branched;
 /** Register A. */
 uint8_t     a;
 /** 0xFF00-0xFFFF used for LDH operation. TODO: check what LDH really does */
@@ -50,11 +63,56 @@ uint8_t     hmem[0xFF];
 
 /** Operations list. */
 op*         sops;
+sops_idx    ops_index;
 /** When branching, state to set back when returning. */
 state*      top;
 /** Adresses for jmps and calls, used for labelling. */
 addr_buff   jmp_addr;
 addr_buff   call_addr;
+/** Jump and call targets of both buffers, bit per ROM offset. */
+uint64_t*   targets;
+/** Decoded instructions and data, bit per ROM offset. */
+uint64_t*   visited;
+/** Executed addresses from emulator trace, seeds after static traversal. */
+trace       exec_trace;
+int         tracing;
+uint32_t    trace_word;
+/** Decoded instructions before trace seeds, for coverage report. */
+uint64_t*   static_visited;
+/** Uniform padding regions, --fill, traversal doesn't walk into them. */
+fills       fill_regions;
+uint32_t    fill_min;
+/** Traversal from classifier seeds, it never takes bytes from other instructions. */
+int         seeding;
+/** Imported symbols. */
+syms        symbols;
+/** Data addresses cross references. */
+xrefs       data_refs;
+/** Last immediate loaded to HL on current path, used for jump tables. */
+uint16_t    hl;
+int         hl_valid;
+/** RST vectors dispatching jump tables, -1 when not checked yet. */
+int         rst_jtab[8];
+/** Run statistics, --stats. */
+stats       run_stats;
+/** Trace-event spans, --trace-events. */
+events      trace_events;
+/** Bank files written during traversal, --stream. */
+split_stream stream;
+int         streaming;
+int         stream_bank;
+/** Banks entered and not written yet. */
+int*        stream_entered;
+int         stream_entered_len;
+uint8_t*    stream_active;
+/** Jump and call targets labelled so far, targets waiting for their operation. */
+int         stream_jmp;
+int         stream_call;
+addr_buff   stream_wait_jmp;
+addr_buff   stream_wait_call;
+/** Follow calls and jumps. */
+int         call_follow;
+int         jmp_follow;
 /** Start address. */
 uint16_t    start;
 /** End address. */
@@ -68,6 +126,79 @@ uint32_t phy(uint16_t addr) {
     return ((bank-1) * 0x4000) + addr;
 }
 
+/** Visited offsets, outside of ROM are never decoded. */
+int is_visited(uint32_t off) {
+    if(off >= r->total) return 1;
+    return (visited[off >> 6] >> (off & 63)) & 1;
+}
+
+void set_visited(uint32_t off) {
+    if(off < r->total) visited[off >> 6] |= 1ULL << (off & 63);
+}
+
+/** Next executed address not decoded yet, 0 when trace is exhausted. */
+int trace_next(void) {
+    uint32_t words = (r->total >> 6) + 1;
+
+    if(!static_visited) {
+        static_visited = (uint64_t*)mem_alloc(MEM_WORKLIST, words * sizeof(uint64_t));
+        memcpy(static_visited, visited, words * sizeof(uint64_t));
+    }
+    for(; trace_word < words; trace_word++) {
+        uint64_t w = exec_trace.exec[trace_word] & ~visited[trace_word];
+        while(w) {
+            uint32_t off = (trace_word << 6) + ctz64(w);
+            uint16_t addr = off < 0x4000 ? off : 0x4000 + (off % 0x4000);
+            if(addr < end) {
+                if(off >= 0x4000) bank = off / 0x4000;
+                pc = addr;
+                hl_valid = 0;
+                return 1;
+            }
+            set_visited(off);
+            w &= w - 1;
+        }
+    }
+    return 0;
+}
+
+/** Offset is target of a decoded jump or call, followed or not. */
+int is_target(uint32_t off) {
+    return off < r->total && ((targets[off >> 6] >> (off & 63)) & 1);
+}
+
+/** First target after offset and before limit, limit if there is none. */
+uint32_t next_target(uint32_t off, uint32_t limit) {
+    uint32_t w = (off + 1) >> 6;
+    uint64_t bits;
+
+    if(limit > r->total) limit = r->total;
+    if(off + 1 >= limit) return limit;
+    bits = targets[w] & (~0ULL << ((off + 1) & 63));
+    while(!bits) {
+        if(++w << 6 >= limit) return limit;
+        bits = targets[w];
+    }
+    off = (w << 6) + ctz64(bits);
+    return off < limit ? off : limit;
+}
+
+/** Adds branch to follow later. */
+void push_state(uint16_t addr, int b) {
+    top = state_push(top, addr, b);
+    run_stats.pushes++;
+    if(++run_stats.depth > run_stats.max_depth) run_stats.max_depth = run_stats.depth;
+}
+
+/** Continues with the last added branch. */
+void pop_state(void) {
+    pc = top->pc;
+    bank = top->bank;
+    top = state_pop(top);
+    run_stats.pops++;
+    run_stats.depth--;
+}
+
 /** Relative address (to PC). */
 uint16_t rel_addr(uint8_t addr) {
     if(addr & 0x80)
@@ -79,10 +210,12 @@ uint16_t rel_addr(uint8_t addr) {
 /** Conditional jump #1. */
 void jmp16(uint16_t addr) {
     if(addr < end && phy(addr) < r->total) {
-        sops_set_jmp(sops, phy(pc), phy(addr));
-        top = state_push(top, pc + 3, bank);
+        sops_set_jmp(&ops_index, phy(pc), phy(addr));
+        push_state(pc + 3, bank);
         pc = addr;
+        branched = 1;
     } else {
+        run_stats.out_of_range++;
         printf("[0x%.8X] Warning: Address too high, ignoring 0x%.4X (0x%.8X)\n", 
             phy(pc), addr, phy(addr));
         pc += 3;
@@ -93,11 +226,13 @@ void jmp16(uint16_t addr) {
 uint16_t jmp8(uint8_t addr) {
     uint16_t new_pc = rel_addr(addr);
     if(new_pc < end) {
-        sops_set_jmp(sops, phy(pc), phy(new_pc));
-        top = state_push(top, pc + 2, bank);
+        sops_set_jmp(&ops_index, phy(pc), phy(new_pc));
+        push_state(pc + 2, bank);
         pc = new_pc;
+        branched = 1;
         return new_pc;
     } else {
+        run_stats.out_of_range++;
         printf("[0x%.8X] Warning: Address too high, ignoring 0x%.4X (0x%.8X)\n", 
             phy(pc), new_pc, phy(new_pc));
         pc += 2;
@@ -107,10 +242,12 @@ uint16_t jmp8(uint8_t addr) {
 
 /** Unconditional jump #1. */
 void jmpu16(uint16_t addr) {
+    branched = 1;
     if(addr < end && phy(addr) < r->total) {
-        sops_set_jmp(sops, phy(pc), phy(addr));
+        sops_set_jmp(&ops_index, phy(pc), phy(addr));
         pc = addr;
     } else {
+        run_stats.out_of_range++;
         printf("[0x%.8X] Warning: Address too high, ignoring 0x%.4X (0x%.8X)\n", 
             pc, addr, phy(addr));
         pc = start;
@@ -120,11 +257,13 @@ void jmpu16(uint16_t addr) {
 /** Unconditional jump #2. */
 uint16_t jmpu8(uint8_t addr) {
     uint16_t new_pc = rel_addr(addr);
+    branched = 1;
     if(new_pc < end && phy(new_pc) < r->total) {
-        sops_set_jmp(sops, phy(pc), phy(new_pc));
+        sops_set_jmp(&ops_index, phy(pc), phy(new_pc));
         pc = new_pc;
         return new_pc;
     } else {
+        run_stats.out_of_range++;
         printf("[0x%.8X] Warning: Address too high, ignoring 0x%.4X (0x%.8X)\n", 
             pc, new_pc, phy(new_pc));
         pc = start;
@@ -134,14 +273,104 @@ uint16_t jmpu8(uint8_t addr) {
 
 /** Return from call or jump. */
 void ret(void) {
-    if(top) {
-        pc = top->pc;        
-        bank = top->bank;
-        top = state_pop(top);
-    } else
+    hl_valid = 0;
+    branched = 1;
+    if(top)
+        pop_state();
+    else
         pc = start;
 }
 
+/** Jump table, entries are followed until the next label or invalid address. */
+void jmp_table(uint16_t addr) {
+    uint32_t    toff, off, doff, limit;
+    uint16_t    daddr;
+    op*         oper;
+    int         i;
+
+    if(addr >= end || (toff = phy(addr)) >= r->total) return;
+
+    /* table can't cross memory region */
+    limit = phy(addr < 0x4000 ? 0x3FFF : 0x7FFF) + 1;
+    if(limit > r->total) limit = r->total;
+
+    /* bounded by the next instruction or label */
+    if(sops_contains(&ops_index, toff)) return; /* already followed */
+    if((oper = sops_next(&ops_index, toff, limit))) limit = oper->off;
+    limit = next_target(toff, limit);
+
+    for(i=0, off=toff; i<JTAB_MAX_ENTRIES && off+1 < limit; i++, off += 2) {
+        daddr = r->raw[off] | (r->raw[off+1]<<8);
+        doff = phy(daddr);
+        /* invalid target ends the table */
+        if(daddr >= end || doff >= r->total) break;
+        if(daddr >= 0x104 && daddr < 0x150) break; /* cartridge header */
+        if(doff >= toff && doff < off+2) break; /* inside table */
+        if(doff > toff && doff < limit) limit = doff;
+        if(sops_overlap(&ops_index, off, 2) >= 0) break; /* decoded bytes */
+
+        sprintf(tmp, "DW $%.4X", daddr);
+        oper = op_create(off, &(r->raw[off]), 2, tmp);
+        oper->flags = OP_FLAG_IS_JUMP | OP_FLAG_IS_DATA;
+        oper->addr = doff;
+        sops = sops_add(sops, &ops_index, oper);
+        set_visited(off);
+        addr_buff_add(&jmp_addr, doff);
+        push_state(daddr, bank);
+    }
+}
+
+/** Instruction at pc writes H or L, immediate loaded to HL stays valid only inside table
+    entry load before JP [HL]. */
+void hl_write(void) {
+    uint32_t off = phy(pc);
+    uint32_t lo = phy(pc < 0x4000 ? 0 : 0x4000);
+    uint32_t hi = lo + 0x4000 < r->total ? lo + 0x4000 : r->total;
+
+    if(hl_valid && !jtab_in_tail(r->raw, off, lo, hi)) hl_valid = 0;
+}
+
+/** Jump to HL, followed through jump table or immediate loaded just before. */
+void jmp_hl(void) {
+    uint32_t off = phy(pc);
+    uint32_t lo = phy(pc < 0x4000 ? 0 : 0x4000);
+
+    if(hl_valid) {
+        if(jtab_tail_match(r->raw, off, lo))
+            jmp_table(hl);
+        else if(off - lo >= 3 && r->raw[off-3] == 0x21 && 
+                (r->raw[off-2] | (r->raw[off-1]<<8)) == hl && hl < end && phy(hl) < r->total) {
+            addr_buff_add(&jmp_addr, phy(hl));
+            push_state(hl, bank);
+        }
+    }
+    ret();
+}
+
+/** Restart, call to vector. Jump table follows RST to dispatcher vector. */
+void rst(uint8_t vec) {
+    int i = vec >> 3;
+
+    if(vec >= end || vec >= r->total) {
+        run_stats.out_of_range++;
+        pc += 1;
+        return;
+    }
+    addr_buff_add(&call_addr, vec);
+    if(rst_jtab[i] < 0)
+        rst_jtab[i] = jtab_rst_dispatcher(r->raw, r->total, vec);
+    if(rst_jtab[i]) {
+        if(call_follow) push_state(vec, bank);
+        jmp_table(pc + 1);
+        ret();
+    } else if(call_follow) {
+        push_state(pc + 1, bank);
+        pc = vec;
+        branched = 1;
+    } else
+        pc += 1;
+}
+
 /** No-arg operator */
 op* op_0(const char* opname) {
     return op_create(phy(pc), &(r->raw[phy(pc)]), 1, opname);
@@ -196,29 +425,324 @@ op* op_lb8(const char* opname, uint8_t addr, const char* right) {
 
 void usage(const char* argv0) {
     printf(
-        "Usage: %s <ROM> -s <HEX> -b <BANK> -a -nc -nj\n"
+        "Usage: %s <ROM> -s <HEX> -b <BANK> -a -nc -nj [--dot <FILE>]\n"
         "<ROM> -> obligatory, ROM file to be disassembled\n"
         "  -s  -> optional, start address (PC), default is 0x100\n"
         "  -e  -> optional, end adress (PC), default is 0x8000\n"
         "  -b  -> optional, memory bank number, default is 1\n"
         "  -a  -> optional, print assembly, default is print binary dump\n"
         "  -nc -> optional, don't follow call instructions, default is to follow\n"
-        "  -nj -> optional, don't follow jump instructions, default is to follow\n", 
+        "  -nj -> optional, don't follow jump instructions, default is to follow\n"
+        "  --dot <FILE>     -> optional, write control flow graph in Graphviz format\n"
+        "  --dot-bank <DEC> -> optional, graph of physical bank only\n"
+        "  --dot-func <HEX> -> optional, graph of function at physical address only\n"
+        "  --funcs <FILE>   -> optional, write functions with call graph summary\n"
+        "  --threads <DEC>  -> optional, threads for per function analyses and assembly\n"
+        "                      formatting, default is CPUs count, assembly uses at most CPUs count\n"
+        "  --xref <HEX>     -> optional, print instructions reading (R), writing (W) or loading (P)\n"
+        "                      the address instead of disassembly\n"
+        "  --xrefs <FILE>   -> optional, write all data cross references\n"
+        "  --sym <FILE>     -> optional, import labels from BB:AAAA name symbols file,\n"
+        "                      ROM symbols are followed as code, RAM symbols get EQU lines\n"
+        "  --emit-sym <FILE> -> optional, write labels as BB:AAAA name symbols file\n"
+        "  --trace <FILE>   -> optional, follow executed addresses from emulator trace,\n"
+        "                      coverage report is printed to stderr\n"
+        "  --stats          -> optional, print phase times and traversal counters to stderr\n"
+        "  --stats-json <FILE> -> optional, write phase times and counters as JSON\n"
+        "  --perf-counters  -> optional, add hardware performance counters per phase to statistics\n"
+        "  --trace-events <FILE> -> optional, write phase, bank, function and worker spans\n"
+        "                      as Chrome trace-event JSON\n"
+        "  --alloc-stats    -> optional, print allocations per subsystem to stderr at exit\n"
+        "  --verify         -> optional, re-encode disassembly and compare it with ROM,\n"
+        "                      first mismatch is printed to stderr\n"
+        "  --histogram      -> optional, print opcode, control flow and per bank byte histograms\n"
+        "                      to stderr\n"
+        "  --split-banks <DIR> -> optional, write assembly as file per bank with Makefile\n"
+        "                      to directory instead of printing it\n"
+        "  --stream         -> optional, write bank files as soon as traversal leaves them\n"
+        "                      for good, files are the same as without it\n"
+        "  --data-as-db     -> optional, print data as DB lines instead of INCBIN of ROM file\n"
+        "  --fill <DEC>     -> optional, print uniform runs of at least DEC bytes (32 or more)\n"
+        "                      as REPT blocks and don't follow code into them\n"
+        "  --classify       -> optional, follow code found by statistics in bytes traversal\n"
+        "                      didn't reach\n"
+        "  --asm <FILE>     -> optional, write assembly to file\n"
+        "  --dump <FILE>    -> optional, write binary dump to file\n"
+        "  --json <FILE>    -> optional, write operations with labels as JSON,\n"
+        "                      outputs to files are written in one pass instead of printing\n"
+        "  --format <text|bin> -> optional, format of --dump file, bin is columnar binary\n"
+        "                      read by opsbin.h, default is text\n", 
         argv0);
 }
 
-/* Remember the times when you put everything in main? They are coming back! */
-int main(int argc, char** argv) {
+/** Resets traversal state for loaded ROM, start, end and bank are kept. */
+void disasm_init(void) {
+    int i;
+
+    sops = NULL;
+    sops_idx_init(&ops_index, r->total);
+    top = NULL;
+    addr_buff_init(&call_addr);
+    addr_buff_init(&jmp_addr);
+    targets = (uint64_t*)mem_calloc(MEM_TARGETS, (r->total >> 6) + 1, sizeof(uint64_t));
+    jmp_addr.map = call_addr.map = targets;
+    jmp_addr.total = call_addr.total = r->total;
+    xrefs_init(&data_refs);
+    syms_init(&symbols);
+    visited = (uint64_t*)mem_calloc(MEM_WORKLIST, (r->total >> 6) + 1, sizeof(uint64_t));
+    static_visited = NULL;
+    tracing = 0;
+    trace_word = 0;
+    pc = start;
+    hl_valid = 0;
+    for(i=0; i<8; i++) rst_jtab[i] = -1;
+    switch(rom_header(r)->type) {
+        case 0x00: /* ROM ONLY */
+        case 0x08: /* ROM+RAM */
+        case 0x09: /* ROM+RAM+BATTERY */
+            mbc = ROM_ONLY; break;
+        default: mbc = MBC1; /* TODO */
+    }
+}
+
+/** Decodes instruction at pc and moves pc to the next one to follow.
+    Returns 1 if pc falls through to the instruction right after the decoded one. */
+int disasm_step(void) {
     uint8_t     addr8;
     uint16_t    addr16;
+    uint16_t    next = pc + OPDESC_LEN[r->raw[phy(pc)]];
+
+    run_stats.decoded++;
+    branched = 0;
+    /* big switch interpreting the operations */
+    switch(r->raw[phy(pc)]) {
+#include "generated.h"
+        default:
+            printf("Warning: Unknown opcode (0x%.2X) at 0x%.8X\n", r->raw[phy(pc)], phy(pc));
+            run_stats.unknown++;
+            sops = sops_add(sops, &ops_index, op_0("-"));
+            pc = start;
+            return 0;
+    }
+    return !branched && pc == next;
+}
+
+/** Sets label flag, or keeps target for later when it's not decoded yet. */
+void stream_flag(addr_buff* wait, uint32_t addr, uint8_t flag) {
+    op* o = sops_get(&ops_index, addr);
+    if(o)
+        o->flags |= flag;
+    else
+        addr_buff_add(wait, addr);
+}
+
+/** Labels of targets found since last call, same flags as disasm_label sets at the end. */
+void stream_label(void) {
+    int i, n;
+
+    for(i=0, n=stream_wait_jmp.len, stream_wait_jmp.len=0; i<n; i++)
+        stream_flag(&stream_wait_jmp, stream_wait_jmp.addr[i], OP_FLAG_JMP_ADDR);
+    for(i=0, n=stream_wait_call.len, stream_wait_call.len=0; i<n; i++)
+        stream_flag(&stream_wait_call, stream_wait_call.addr[i], OP_FLAG_CALL_ADDR);
+    for(; stream_jmp < jmp_addr.len; stream_jmp++)
+        stream_flag(&stream_wait_jmp, jmp_addr.addr[stream_jmp], OP_FLAG_JMP_ADDR);
+    for(; stream_call < call_addr.len; stream_call++)
+        stream_flag(&stream_wait_call, call_addr.addr[stream_call], OP_FLAG_CALL_ADDR);
+}
+
+void stream_init(void) {
+    stream_entered = (int*)mem_alloc(MEM_OUTPUT, stream.banks * sizeof(int));
+    stream_active = (uint8_t*)mem_alloc(MEM_OUTPUT, stream.banks);
+    stream_entered_len = 0;
+    stream_bank = -1;
+    stream_jmp = stream_call = 0;
+    addr_buff_init(&stream_wait_jmp);
+    addr_buff_init(&stream_wait_call);
+}
+
+void stream_free(void) {
+    mem_free(stream_entered);
+    mem_free(stream_active);
+    addr_buff_free(&stream_wait_jmp);
+    addr_buff_free(&stream_wait_call);
+    split_stream_free(&stream);
+}
+
+/** Called when traversal moves to other bank, writes entered banks no pending branch can
+    continue in: not current bank, bank of current pc or bank of any state on stack. */
+void stream_seal(void) {
+    state*  st;
+    double  span_start;
+    int     i, b, n = 0, labelled = 0;
+
+    if(stream_bank > 0 && stream_bank < stream.banks && !stream.seals[stream_bank].written) {
+        for(i=0; i<stream_entered_len && stream_entered[i] != stream_bank; i++);
+        if(i == stream_entered_len) stream_entered[stream_entered_len++] = stream_bank;
+    }
+    memset(stream_active, 0, stream.banks);
+    if(bank >= 0 && bank < stream.banks) stream_active[bank] = 1;
+    if(stream_bank >= 0 && stream_bank < stream.banks) stream_active[stream_bank] = 1;
+    for(st = top; st; st = st->prev)
+        if(st->bank >= 0 && st->bank < stream.banks) stream_active[st->bank] = 1;
+
+    for(i=0; i<stream_entered_len; i++) {
+        b = stream_entered[i];
+        if(stream_active[b]) {
+            stream_entered[n++] = b;
+            continue;
+        }
+        if(!labelled++) stream_label();
+        span_start = events_now(&trace_events);
+        if(split_stream_bank(&stream, b, &ops_index) < 0)
+            printf("Could not write bank %d to %s\n", b, stream.sp.dir);
+        events_span(&trace_events, "seal %02X", "emit", span_start, b);
+    }
+    stream_entered_len = n;
+}
+
+/** Instruction at pc overlaps decoded ones. Branch target wins over instruction reached from
+    the previous one and removes it, data, targets and instructions decoded first win otherwise.
+    Returns 1 if path at pc loses. */
+int overlapped(int walked) {
+    uint32_t    off = phy(pc);
+    uint32_t    len = OPDESC_LEN[r->raw[off]] ? OPDESC_LEN[r->raw[off]] : 1;
+    uint8_t     own;
+    int         other;
+
+    while((other = sops_overlap(&ops_index, off, len)) >= 0) {
+        own = ops_index.own[other];
+        run_stats.overlaps++;
+        printf("[0x%.8X] Warning: Instruction overlaps %s at 0x%.8X\n", off,
+            (own & OWN_STATE) == OWN_DATA ? "data" : "instruction", other);
+        if(walked || seeding || (own & OWN_STATE) == OWN_DATA || (own & OWN_TARGET)) return 1;
+        /* labelled by a jump not followed or not popped yet */
+        if(is_target(other)) {
+            ops_index.own[other] |= OWN_TARGET;
+            return 1;
+        }
+        sops = sops_remove(sops, &ops_index, other);
+    }
+    if(!walked) ops_index.own[off] |= OWN_TARGET;
+    return 0;
+}
+
+/** Disassembling loop, until there are no branches left to follow. */
+void disasm_run(void) {
+    double      span_start = 0;
+    int         span_bank = -1;
+    /* pc is right after previous instruction, walked into, not branched to */
+    int         walked = 0;
+
+    while(1) {
+        /* Limit PC. */
+        if(pc >= end) {
+            pc = start;
+            walked = 0;
+        }
+        
+        /* Do not visit same instruction twice, nor walk into padding or other instructions,
+           next branch is checked the same way */
+        if(is_visited(phy(pc)) || (walked && fills_blocks(&fill_regions, phy(pc))) || overlapped(walked)) {
+            /* Check if we have any other possible branches to follow */
+            if(is_visited(phy(pc))) {
+                run_stats.revisits++;
+                /* branch to decoded instruction protects it like the first one */
+                if(!walked && phy(pc) < r->total && (ops_index.own[phy(pc)] & OWN_STATE) == OWN_CODE)
+                    ops_index.own[phy(pc)] |= OWN_TARGET;
+            } else if(walked && fills_blocks(&fill_regions, phy(pc)))
+                run_stats.fill_rejections++;
+            if(top) {
+                pop_state();
+                hl_valid = 0;
+            } else if(!tracing || !trace_next())
+                break;
+            walked = 0;
+            continue;
+        }            
+        /* span per bank run, bank 0 calls included */
+        if(trace_events.enabled && (int)(phy(pc) / 0x4000) != span_bank) {
+            if(span_bank >= 0) events_span(&trace_events, "bank %02X", "traverse", span_start, span_bank);
+            span_bank = phy(pc) / 0x4000;
+            span_start = events_now(&trace_events);
+        }
+        /* bank left, --stream writes banks no pending branch returns to */
+        if(streaming && (int)(phy(pc) / 0x4000) != stream_bank) {
+            stream_bank = phy(pc) / 0x4000;
+            stream_seal();
+        }
+        set_visited(phy(pc));
+        walked = disasm_step();
+    }
+    if(span_bank >= 0) events_span(&trace_events, "bank %02X", "traverse", span_start, span_bank);
+}
+
+/** Creates labels for followed jumps and calls. Jumps to targets lost in overlap conflicts keep
+    their address, there is no instruction to label. */
+void disasm_label(void) {
+    op* o;
+    int i;
+
+    if(run_stats.overlaps)
+        for(o = sops; o; o = o->next)
+            if((o->flags & OP_FLAG_IS_JUMP) && !sops_contains(&ops_index, o->addr))
+                sops_clear_flag(&ops_index, o, OP_FLAG_IS_JUMP);
+
+    for(i=0; i<jmp_addr.len; i++)
+        sops_set_flag(&ops_index, jmp_addr.addr[i], OP_FLAG_JMP_ADDR);
+    for(i=0; i<call_addr.len; i++)
+        sops_set_flag(&ops_index, call_addr.addr[i], OP_FLAG_CALL_ADDR);
+}
+
+/** Frees everything from disasm_init, ROM is kept. */
+void disasm_free(void) {
+    sops_free(sops);
+    sops_idx_free(&ops_index);
+    state_free(top);
+    addr_buff_free(&call_addr);
+    addr_buff_free(&jmp_addr);
+    mem_free(targets);
+    xrefs_free(&data_refs);
+    syms_free(&symbols);
+    mem_free(visited);
+}
+
+#ifndef GB_DISASM_NO_MAIN
+/* Remember the times when you put everything in main? They are coming back! */
+int main(int argc, char** argv) {
     int         i;
 
     /* Params. */
     int         assembly = 0;
-    int         call_follow = 1;
-    int         jmp_follow = 1;
+    const char* dot_file = NULL;
+    int         dot_bank = -1;
+    int         dot_func = -1;
+    const char* funcs_file = NULL;
+    int         threads = pool_cpus();
+    int         xref_addr = -1;
+    const char* xrefs_file = NULL;
+    const char* sym_file = NULL;
+    const char* trace_file = NULL;
+    int         stats_text = 0;
+    const char* stats_file = NULL;
+    perf        counters;
+    int         perf_counters = 0;
+    const char* events_file = NULL;
+    int         alloc_stats = 0;
+    int         verify = 0;
+    int         histogram = 0;
+    int         classify = 0;
+    const char* split_dir = NULL;
+    const char* emit_files[EMITTER_KINDS];
+    int         binary = 0;
+    emitter     emit;
+    int         ret = 0;
+    cfg*        graph = NULL;
+    funcs*      fs = NULL;
     
     /* Default values. */
+    memset(emit_files, 0, sizeof(emit_files));
+    call_follow = 1;
+    jmp_follow  = 1;
     bank        = 1;
     start       = 0x100;
     end         = 0x8000;
@@ -288,6 +812,202 @@ int main(int argc, char** argv) {
                     usage(argv[0]);
                     return -4;
                 }
+            } else if (strcmp(argv[arg], "--dot") == 0) {
+                if(arg+1 < argc) {
+                    dot_file = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the graph file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--dot-bank") == 0) {
+                if(arg+1 < argc) {
+                    sscanf(argv[arg+1], "%d", &dot_bank);
+                    arg += 2;
+                } else {
+                    puts("Specify the graph bank number");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--dot-func") == 0) {
+                if(arg+1 < argc) {
+                    sscanf(argv[arg+1], "%X", &dot_func);
+                    arg += 2;
+                } else {
+                    puts("Specify the graph function address");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--funcs") == 0) {
+                if(arg+1 < argc) {
+                    funcs_file = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the functions file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--threads") == 0) {
+                if(arg+1 < argc) {
+                    sscanf(argv[arg+1], "%d", &threads);
+                    arg += 2;
+                } else {
+                    puts("Specify the number of threads");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--xref") == 0) {
+                if(arg+1 < argc) {
+                    sscanf(argv[arg+1], "%X", &xref_addr);
+                    if(xref_addr < 0 || xref_addr > 0xFFFF) {
+                        puts("Cross reference address must be in range 0x0000-0xFFFF");
+                        return -9;
+                    }
+                    arg += 2;
+                } else {
+                    puts("Specify the cross reference address");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--xrefs") == 0) {
+                if(arg+1 < argc) {
+                    xrefs_file = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the cross references file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--sym") == 0) {
+                if(arg+1 < argc) {
+                    sym_file = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the symbols file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--emit-sym") == 0) {
+                if(arg+1 < argc) {
+                    emit_files[EMITTER_SYM] = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the symbols file to write");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--trace") == 0) {
+                if(arg+1 < argc) {
+                    trace_file = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the trace file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--stats") == 0) {
+                stats_text = 1;
+                arg++;
+            } else if (strcmp(argv[arg], "--asm") == 0) {
+                if(arg+1 < argc) {
+                    emit_files[EMITTER_ASM] = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the assembly file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--dump") == 0) {
+                if(arg+1 < argc) {
+                    emit_files[EMITTER_DUMP] = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the dump file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--format") == 0) {
+                if(arg+1 < argc && (strcmp(argv[arg+1], "text") == 0 || strcmp(argv[arg+1], "bin") == 0)) {
+                    binary = strcmp(argv[arg+1], "bin") == 0;
+                    arg += 2;
+                } else {
+                    puts("Specify the dump format, text or bin");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--json") == 0) {
+                if(arg+1 < argc) {
+                    emit_files[EMITTER_JSON] = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the JSON file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--split-banks") == 0) {
+                if(arg+1 < argc) {
+                    split_dir = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the banks directory");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--data-as-db") == 0) {
+                sops_db = 1;
+                arg++;
+            } else if (strcmp(argv[arg], "--fill") == 0) {
+                if(arg+1 < argc) {
+                    sscanf(argv[arg+1], "%u", &fill_min);
+                    if(fill_min < FILL_MIN) {
+                        printf("Fill length must be at least %d\n", FILL_MIN);
+                        return -13;
+                    }
+                    arg += 2;
+                } else {
+                    puts("Specify the shortest fill length");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--stream") == 0) {
+                streaming = 1;
+                arg++;
+            } else if (strcmp(argv[arg], "--classify") == 0) {
+                classify = 1;
+                arg++;
+            } else if (strcmp(argv[arg], "--histogram") == 0) {
+                histogram = 1;
+                arg++;
+            } else if (strcmp(argv[arg], "--verify") == 0) {
+                verify = 1;
+                arg++;
+            } else if (strcmp(argv[arg], "--alloc-stats") == 0) {
+                /* nothing is allocated while parsing parameters */
+                alloc_stats = 1;
+                mem.enabled = 1;
+                arg++;
+            } else if (strcmp(argv[arg], "--perf-counters") == 0) {
+                perf_counters = 1;
+                arg++;
+            } else if (strcmp(argv[arg], "--stats-json") == 0) {
+                if(arg+1 < argc) {
+                    stats_file = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the statistics file");
+                    usage(argv[0]);
+                    return -4;
+                }
+            } else if (strcmp(argv[arg], "--trace-events") == 0) {
+                if(arg+1 < argc) {
+                    events_file = argv[arg+1];
+                    arg += 2;
+                } else {
+                    puts("Specify the trace events file");
+                    usage(argv[0]);
+                    return -4;
+                }
             } else {
                 printf("Uknown argument %s\n", argv[arg]);
                 usage(argv[0]);
@@ -296,73 +1016,274 @@ int main(int argc, char** argv) {
         }
     }
 
+    /* Only bank files can be written before traversal ends, bank 0 is never sealed. */
+    if(streaming && !split_dir) {
+        puts("Streaming is available with --split-banks");
+        usage(argv[0]);
+        return -4;
+    }
+
+    /* Binary dump, stdout has log messages. */
+    if(binary) {
+        if(!emit_files[EMITTER_DUMP] || strcmp(emit_files[EMITTER_DUMP], "-") == 0) {
+            puts("Binary format is written to --dump file");
+            usage(argv[0]);
+            return -4;
+        }
+        emit_files[EMITTER_BIN] = emit_files[EMITTER_DUMP];
+        emit_files[EMITTER_DUMP] = NULL;
+    }
+
+    /* Hardware counters are reported with statistics. */
+    if(perf_counters) {
+        if(!perf_open(&counters))
+            fprintf(stderr, "Performance counters are not available, reporting times only\n");
+        run_stats.counters = &counters;
+        if(!stats_file) stats_text = 1;
+    }
+    if(events_file) {
+        events_init(&trace_events);
+        run_stats.spans = &trace_events;
+    }
+
     /* Load ROM. */
+    stats_begin(&run_stats);
     r = rom_load(argv[1]);
     if(!r) {
         printf("Could not load ROM file %s\n", argv[1]);
         return -2;
     }
+    /* padding is known before traversal, it is not followed */
+    if(fill_min) {
+        fills_scan(&fill_regions, r->raw, r->total, fill_min);
+        sops_fills = &fill_regions;
+        run_stats.fill_bytes = fill_regions.bytes;
+    }
+    stats_end(&run_stats, STATS_LOAD);
     
-    if(!assembly) rom_info(r);
+    if(!assembly && xref_addr < 0) rom_info(r);
     
-    /* Init globals. */
-    sops = NULL;
-    top = NULL;
-    addr_buff_init(&call_addr);
-    addr_buff_init(&jmp_addr);
-    pc = start;
-    switch(rom_header(r)->type) {
-        case 0x00: /* ROM ONLY */
-        case 0x08: /* ROM+RAM */
-        case 0x09: /* ROM+RAM+BATTERY */
-            mbc = ROM_ONLY; break;
-        default: mbc = MBC1; /* TODO */
+    stats_begin(&run_stats);
+    disasm_init();
+
+    /* Symbols in ROM banks are followed after start address. */
+    if(sym_file) {
+        if(syms_load(&symbols, sym_file) < 0) {
+            printf("Could not load symbols file %s\n", sym_file);
+            return -10;
+        }
+        for(i=symbols.len-1; i>=0; i--) {
+            int      sbank = SYM_BANK(symbols.list[i].key);
+            uint16_t saddr = SYM_ADDR(symbols.list[i].key);
+            uint32_t soff;
+            if(saddr >= end) continue;
+            if(saddr < 0x4000)
+                sbank = bank;
+            else if(sbank == 0)
+                sbank = 1;
+            soff = (saddr < 0x4000 || mbc == ROM_ONLY) ? saddr : sbank * 0x4000 + saddr - 0x4000;
+            if(soff < r->total)
+                push_state(saddr, sbank);
+        }
     }
 
-    /* Disassembling loop. */
-    while(1) {
-        /* Limit PC. */
-        if(pc >= end) pc = start;
-        
-        /* Do not visit same instruction twice */
-        if(sops_contains(sops, phy(pc))) {
-            /* Check if we have any other possible branches to follow */
-            if(top) {
-                pc = top->pc;
-                bank = top->bank;
-                top = state_pop(top);
-            } else
-                goto finish;
-        }            
-           
-        /* big switch interpreting the operations */
-        switch(r->raw[phy(pc)]) {
-#include "generated.h"
-            default:
-                printf("Warning: Unknown opcode (0x%.2X) at 0x%.8X\n", r->raw[phy(pc)], phy(pc));
-                sops = sops_add(sops, op_0("-"));
-                pc = start;
+    /* Executed addresses are followed when nothing else is left. */
+    if(trace_file) {
+        trace_init(&exec_trace, r->total);
+        if(trace_load(&exec_trace, trace_file) < 0) {
+            printf("Could not load trace file %s\n", trace_file);
+            return -11;
         }
+        tracing = 1;
     }
+    stats_end(&run_stats, STATS_LOAD);
 
-finish:
-    /* create labels for followed jumps and calls */
-    for(i=0; i<jmp_addr.len; i++)
-        sops_set_flag(sops, jmp_addr.addr[i], OP_FLAG_JMP_ADDR);
-    for(i=0; i<call_addr.len; i++)
-        sops_set_flag(sops, call_addr.addr[i], OP_FLAG_CALL_ADDR);
+    /* banks are written during traversal, or all after it if directory is not writable */
+    if(streaming) {
+        if(split_stream_init(&stream, split_dir, r, &symbols) == 0)
+            stream_init();
+        else
+            streaming = 0;
+    }
+
+    stats_begin(&run_stats);
+    disasm_run();
+    stats_end(&run_stats, STATS_TRAVERSE);
+    /* code nothing reaches, seeds are followed like branches */
+    if(classify) {
+        classifier c;
+        int        round, n;
+
+        classify_init(&c, r->total, targets);
+        for(round=0; round<CLASSIFY_ROUNDS; round++) {
+            stats_begin(&run_stats);
+            classify_learn(&c, &ops_index, r);
+            n = classify_gaps(&c, &ops_index, r, &fill_regions, end);
+            stats_end(&run_stats, STATS_ANALYSIS);
+            if(!n) break;
+            run_stats.seeds += n;
+            for(i=n-1; i>=0; i--) {
+                uint32_t soff = c.seeds[i];
+                if(soff < 0x4000)
+                    push_state(soff, bank);
+                else
+                    push_state(0x4000 + (soff & 0x3FFF), soff / 0x4000);
+            }
+            stats_begin(&run_stats);
+            seeding = 1;
+            disasm_run();
+            seeding = 0;
+            stats_end(&run_stats, STATS_TRAVERSE);
+        }
+        classify_free(&c);
+    }
+    if(tracing) {
+        trace_report(&exec_trace, static_visited ? static_visited : visited, stderr);
+        trace_free(&exec_trace);
+        mem_free(static_visited);
+    }
+    stats_begin(&run_stats);
+    disasm_label();
+    stats_end(&run_stats, STATS_LABEL);
+
+    /* round-trip */
+    if(verify) {
+        encoder         enc;
+        encode_result   res;
+
+        stats_begin(&run_stats);
+        encode_init(&enc);
+        encode_roundtrip(&enc, sops, &ops_index, &symbols, r, &res);
+        if(encode_report(&res, &ops_index, r, stderr) < 0) ret = -12;
+        stats_end(&run_stats, STATS_ANALYSIS);
+    }
     
-    /* print results */
-    if(assembly) 
-        sops_asm(sops, stdout, r); 
-    else 
-        sops_dump(sops, stdout);
+    /* histograms */
+    if(histogram) {
+        histo h;
+
+        stats_begin(&run_stats);
+        histo_build(&h, sops, r);
+        stats_end(&run_stats, STATS_ANALYSIS);
+        stats_begin(&run_stats);
+        histo_print(&h, stderr);
+        histo_free(&h);
+        stats_end(&run_stats, STATS_EMIT);
+    }
+
+    /* cross references */
+    stats_begin(&run_stats);
+    xrefs_index(&data_refs, sops);
+    stats_end(&run_stats, STATS_ANALYSIS);
+    stats_begin(&run_stats);
+    if(xrefs_file) {
+        FILE* f = fopen(xrefs_file, "w");
+        if(f) {
+            xrefs_dump(&data_refs, f);
+            fclose(f);
+        } else
+            printf("Could not open cross references file %s\n", xrefs_file);
+    }
+
+    stats_end(&run_stats, STATS_EMIT);
+
+    /* control flow graph and functions */
+    stats_begin(&run_stats);
+    if(dot_file || funcs_file)
+        graph = cfg_build(sops, r->total);
+    if(funcs_file) {
+        fs = func_build(graph, phy(start));
+        func_bottom_up(fs, graph, func_depth_pass, NULL, threads,
+            events_file ? &trace_events : NULL);
+    }
+    stats_end(&run_stats, STATS_ANALYSIS);
+
+    stats_begin(&run_stats);
+    if(dot_file) {
+        FILE* f = fopen(dot_file, "w");
+        if(f) {
+            if(dot_func >= 0)
+                cfg_dot_func(graph, f, dot_func);
+            else if(dot_bank >= 0)
+                cfg_dot_range(graph, f, dot_bank * 0x4000, (dot_bank+1) * 0x4000);
+            else
+                cfg_dot_range(graph, f, 0, r->total);
+            fclose(f);
+        } else
+            printf("Could not open graph file %s\n", dot_file);
+    }
+    if(funcs_file) {
+        FILE* f = fopen(funcs_file, "w");
+        if(f) {
+            func_dump(fs, graph, f);
+            fclose(f);
+        } else
+            printf("Could not open functions file %s\n", funcs_file);
+    }
+
+    /* print results, files and sequential stdout output in one pass */
+    emitter_init(&emit, r, &symbols);
+    for(i=0; i<EMITTER_KINDS; i++) {
+        if(emit_files[i] && emitter_open(&emit, i, emit_files[i]) < 0)
+            printf("Could not open output file %s\n", emit_files[i]);
+    }
+    /* bank files don't depend on other outputs, streamed banks are finished */
+    if(split_dir) {
+        if((streaming ? split_stream_finish(&stream, sops, &ops_index, threads,
+                    events_file ? &trace_events : NULL) :
+                split_banks(split_dir, sops, &ops_index, r, &symbols, threads,
+                    events_file ? &trace_events : NULL)) < 0)
+            printf("Could not write banks to %s\n", split_dir);
+    }
+    if(xref_addr >= 0)
+        xrefs_query(&data_refs, xref_addr, stdout);
+    else if(split_dir || emit_files[EMITTER_ASM] || emit_files[EMITTER_DUMP] ||
+            emit_files[EMITTER_JSON] || emit_files[EMITTER_BIN])
+        ; /* written to files instead */
+    else if(assembly && threads > 1) {
+        if(emit_asm(sops, stdout, r, &symbols, threads, events_file ? &trace_events : NULL) < 0)
+            fprintf(stderr, "Could not write output\n");
+    }
+    else
+        emit.out[assembly ? EMITTER_ASM : EMITTER_DUMP] = stdout;
+    if(emitter_run(&emit, sops) < 0)
+        fprintf(stderr, "Could not write output\n");
+    fflush(stdout);
+    stats_end(&run_stats, STATS_EMIT);
+
+    if(stats_text)
+        stats_print(&run_stats, stderr);
+    if(stats_file) {
+        FILE* f = fopen(stats_file, "w");
+        if(f) {
+            stats_json(&run_stats, f);
+            fclose(f);
+        } else
+            printf("Could not open statistics file %s\n", stats_file);
+    }
+    if(perf_counters) perf_close(&counters);
+    if(events_file) {
+        FILE* f = fopen(events_file, "w");
+        if(f) {
+            events_write(&trace_events, f);
+            fclose(f);
+        } else
+            printf("Could not open trace events file %s\n", events_file);
+        events_free(&trace_events);
+    }
 
     /* Free reources. */
+    if(streaming) stream_free();
+    disasm_free();
+    if(fill_min) fills_free(&fill_regions);
     rom_free(r);
-    state_free(top);
-    addr_buff_free(&call_addr);
-    addr_buff_free(&jmp_addr);
+    func_free(fs);
+    cfg_free(graph);
+
+    /* after everything is freed, live bytes are leaks */
+    if(alloc_stats)
+        mem_print(stderr);
     
-    return 0;
+    return ret;
 }
+#endif
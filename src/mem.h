@@ -0,0 +1,141 @@
+#ifndef __GB_DASM_MEM_H__
+#define __GB_DASM_MEM_H__
+
+/* mem.h: Allocations tagged by subsystem, counted for --alloc-stats.
+
+   Every block has a small header with its size and tag, so frees are
+   attributed without the caller passing them. Counting is off by default. */
+
+#include "stdinc.h"
+
+/* Tags. */
+#define MEM_OPS         0 /* operations and their index */
+#define MEM_WORKLIST    1 /* branch states, visited bitmaps */
+#define MEM_TARGETS     2 /* jump and call targets */
+#define MEM_ROM         3
+#define MEM_OUTPUT      4 /* emitters */
+#define MEM_ANALYSIS    5 /* graph, functions, cross references, thread pool */
+#define MEM_SYMBOLS     6
+#define MEM_TRACE       7 /* emulator trace, trace events */
+#define MEM_TAGS        8
+
+static const char* MEM_TAG_NAMES[MEM_TAGS] = {
+    "ops", "worklist", "targets", "rom", "output", "analysis", "symbols", "trace"
+};
+
+/** Header before every block, 16 bytes keep the alignment of malloc. */
+typedef struct mem_hdr {
+    uint64_t    size;
+    uint64_t    tag;
+} mem_hdr;
+
+typedef struct mem_stats {
+    int         enabled;
+    /** Allocations, bytes allocated, live and peak live bytes per tag. */
+    uint64_t    count[MEM_TAGS];
+    uint64_t    bytes[MEM_TAGS];
+    uint64_t    live[MEM_TAGS];
+    uint64_t    peak[MEM_TAGS];
+    uint64_t    frees[MEM_TAGS];
+} mem_stats;
+
+mem_stats mem;
+
+/** Atomic add, returns new value. */
+uint64_t mem_add(uint64_t* x, uint64_t v) {
+#ifdef _WIN32
+    return *x += v;
+#else
+    return __sync_add_and_fetch(x, v);
+#endif
+}
+
+void mem_count(int tag, uint64_t size) {
+    uint64_t live;
+
+    mem_add(&mem.count[tag], 1);
+    mem_add(&mem.bytes[tag], size);
+    live = mem_add(&mem.live[tag], size);
+    /* peak may miss concurrent maximum by one allocation */
+    if(live > mem.peak[tag]) mem.peak[tag] = live;
+}
+
+void mem_uncount(const mem_hdr* h) {
+    mem_add(&mem.frees[h->tag], 1);
+    mem_add(&mem.live[h->tag], (uint64_t)0 - h->size);
+}
+
+void* mem_alloc(int tag, size_t size) {
+    mem_hdr* h = (mem_hdr*)malloc(sizeof(mem_hdr) + size);
+
+    if(!h) return NULL;
+    h->size = size;
+    h->tag = tag;
+    if(mem.enabled) mem_count(tag, size);
+    return h + 1;
+}
+
+void* mem_calloc(int tag, size_t n, size_t size) {
+    mem_hdr* h = (mem_hdr*)calloc(1, sizeof(mem_hdr) + n * size);
+
+    if(!h) return NULL;
+    h->size = n * size;
+    h->tag = tag;
+    if(mem.enabled) mem_count(tag, n * size);
+    return h + 1;
+}
+
+void mem_free(void* p) {
+    mem_hdr* h;
+
+    if(!p) return;
+    h = (mem_hdr*)p - 1;
+    if(mem.enabled) mem_uncount(h);
+    free(h);
+}
+
+/** Resized block keeps its tag. */
+void* mem_realloc(int tag, void* p, size_t size) {
+    mem_hdr* h;
+
+    if(!p) return mem_alloc(tag, size);
+    h = (mem_hdr*)p - 1;
+    if(mem.enabled) mem_uncount(h);
+    h = (mem_hdr*)realloc(h, sizeof(mem_hdr) + size);
+    if(!h) return NULL;
+    h->size = size;
+    if(mem.enabled) mem_count((int)h->tag, size);
+    return h + 1;
+}
+
+char* mem_strdup(int tag, const char* s) {
+    size_t  len = strlen(s) + 1;
+    char*   d = (char*)mem_alloc(tag, len);
+
+    if(d) memcpy(d, s, len);
+    return d;
+}
+
+/** Count, bytes, peak and live bytes per tag. */
+void mem_print(FILE* f) {
+    uint64_t    count = 0, bytes = 0, live = 0, frees = 0;
+    int         i;
+
+    fprintf(f, "Allocations:\n");
+    fprintf(f, "  %-10s %12s %14s %14s %14s %12s\n", "tag", "count", "bytes", "peak", "live", "live count");
+    for(i=0; i<MEM_TAGS; i++) {
+        fprintf(f, "  %-10s %12llu %14llu %14llu %14llu %12llu\n", MEM_TAG_NAMES[i],
+            (unsigned long long)mem.count[i], (unsigned long long)mem.bytes[i],
+            (unsigned long long)mem.peak[i], (unsigned long long)mem.live[i],
+            (unsigned long long)(mem.count[i] - mem.frees[i]));
+        count += mem.count[i];
+        bytes += mem.bytes[i];
+        live += mem.live[i];
+        frees += mem.frees[i];
+    }
+    fprintf(f, "  %-10s %12llu %14llu %14s %14llu %12llu\n", "total",
+        (unsigned long long)count, (unsigned long long)bytes, "",
+        (unsigned long long)live, (unsigned long long)(count - frees));
+}
+
+#endif
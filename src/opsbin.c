@@ -0,0 +1,58 @@
+/* opsbin.c: Converter of columnar binary operations file (--format bin) back
+   to text dump, same as gb-disasm prints. Example of opsbin.h reader. */
+
+#include "opsbin.h"
+
+void usage(const char* argv0) {
+    printf("Usage: %s <FILE> [-l] [-i]\n"
+        "<FILE> -> obligatory, operations file written with --format bin\n"
+        "  -l   -> optional, print labels before their operations\n"
+        "  -i   -> optional, print header information only\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    opsbin      b;
+    const char* label;
+    int         labels = 0, info = 0, arg, ret;
+    uint32_t    i;
+
+    if(argc < 2) {
+        usage(argv[0]);
+        return -1;
+    }
+    for(arg=2; arg<argc; arg++) {
+        if(strcmp(argv[arg], "-l") == 0)
+            labels = 1;
+        else if(strcmp(argv[arg], "-i") == 0)
+            info = 1;
+        else {
+            printf("Uknown argument %s\n", argv[arg]);
+            usage(argv[0]);
+            return -3;
+        }
+    }
+
+    if((ret = opsbin_open(&b, argv[1])) < 0) {
+        if(ret == OPSBIN_IO)
+            printf("Could not read file %s\n", argv[1]);
+        else
+            printf("File %s is not an operations file\n", argv[1]);
+        return -2;
+    }
+
+    if(info) {
+        printf("Version: %u\n", b.h->version);
+        printf("Operations: %u\n", b.count);
+        printf("ROM size: %u\n", b.h->rom_size);
+        printf("Strings: %u bytes\n", b.h->strings_size);
+    } else {
+        for(i=0; i<b.count; i++) {
+            if(labels && (label = opsbin_label(&b, i)))
+                printf("%s:\n", label);
+            opsbin_dump_op(&b, i, stdout);
+        }
+    }
+    opsbin_close(&b);
+    return 0;
+}
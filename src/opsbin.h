@@ -0,0 +1,207 @@
+#ifndef __GB_DASM_OPSBIN_H__
+#define __GB_DASM_OPSBIN_H__
+
+/* opsbin.h: Columnar binary operations file (--format bin) and its reader.
+
+   Header is followed by fixed-width columns, one value per operation, and a
+   string table of NUL terminated operation texts and labels. Every column
+   starts at 8-byte aligned offset given in header, values are little-endian.
+   Reader maps the file and points columns into it, nothing is parsed.
+
+   Reader depends on standard headers only, so it can be copied to other
+   projects with stdinc.h. */
+
+#include "stdinc.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define OPSBIN_MAGIC    "GBOP"
+#define OPSBIN_VERSION  1
+/** No target or label. */
+#define OPSBIN_NONE     0xFFFFFFFF
+
+/* Descriptor ids, opcode of OPDESC_TEXT otherwise. */
+#define OPSBIN_DESC_CB      0x100 /* 0x1xx, bit operation of OPDESC_CB_TEXT */
+#define OPSBIN_DESC_DATA    0x200 /* data word */
+
+/* Errors. */
+#define OPSBIN_IO       -1 /* file could not be read */
+#define OPSBIN_FORMAT   -2 /* not an operations file or truncated */
+
+typedef struct opsbin_header {
+    char        magic[4];
+    uint32_t    version;
+    uint32_t    count;
+    uint32_t    rom_size;
+    /** Column offsets from start of file. */
+    uint32_t    off;        /* uint32_t, offset in ROM */
+    uint32_t    len;        /* uint8_t, length in bytes */
+    uint32_t    code;       /* uint8_t[3], binary code, zero padded */
+    uint32_t    flags;      /* uint8_t, OP_FLAG_* */
+    uint32_t    target;     /* uint32_t, jump or call destination, OPSBIN_NONE */
+    uint32_t    desc;       /* uint16_t, descriptor id */
+    uint32_t    text;       /* uint32_t, string offset of operation text */
+    uint32_t    label;      /* uint32_t, string offset of label, OPSBIN_NONE */
+    uint32_t    strings;
+    uint32_t    strings_size;
+} opsbin_header;
+
+/** Mapped file, columns point into it. */
+typedef struct opsbin {
+    const opsbin_header*    h;
+    uint32_t                count;
+    const uint32_t*         off;
+    const uint8_t*          len;
+    const uint8_t*          code;
+    const uint8_t*          flags;
+    const uint32_t*         target;
+    const uint16_t*         desc;
+    const uint32_t*         text;
+    const uint32_t*         label;
+    const char*             strings;
+    void*                   base;
+    size_t                  size;
+} opsbin;
+
+/** Offset of column after one of count values of width bytes, aligned to 8. */
+uint32_t opsbin_next(uint32_t start, uint32_t count, uint32_t width) {
+    return (start + count * width + 7) & ~7U;
+}
+
+/** Column fits in data. */
+int opsbin_fits(uint32_t start, uint32_t count, uint32_t width, size_t size) {
+    return start % 8 == 0 && (uint64_t)start + (uint64_t)count * width <= size;
+}
+
+/** Points columns into data, returns 0 or OPSBIN_FORMAT. */
+int opsbin_map(opsbin* b, const void* data, size_t size) {
+    const opsbin_header* h = (const opsbin_header*)data;
+    uint32_t             n;
+
+    if(size < sizeof(opsbin_header) || memcmp(h->magic, OPSBIN_MAGIC, 4) != 0 ||
+            h->version != OPSBIN_VERSION)
+        return OPSBIN_FORMAT;
+    n = h->count;
+    if(!opsbin_fits(h->off, n, 4, size) || !opsbin_fits(h->len, n, 1, size) ||
+            !opsbin_fits(h->code, n, 3, size) || !opsbin_fits(h->flags, n, 1, size) ||
+            !opsbin_fits(h->target, n, 4, size) || !opsbin_fits(h->desc, n, 2, size) ||
+            !opsbin_fits(h->text, n, 4, size) || !opsbin_fits(h->label, n, 4, size) ||
+            !opsbin_fits(h->strings, h->strings_size, 1, size) ||
+            (h->strings_size && ((const char*)data)[h->strings + h->strings_size - 1] != 0))
+        return OPSBIN_FORMAT;
+    b->h = h;
+    b->count = n;
+    b->off = (const uint32_t*)((const char*)data + h->off);
+    b->len = (const uint8_t*)data + h->len;
+    b->code = (const uint8_t*)data + h->code;
+    b->flags = (const uint8_t*)data + h->flags;
+    b->target = (const uint32_t*)((const char*)data + h->target);
+    b->desc = (const uint16_t*)((const char*)data + h->desc);
+    b->text = (const uint32_t*)((const char*)data + h->text);
+    b->label = (const uint32_t*)((const char*)data + h->label);
+    b->strings = (const char*)data + h->strings;
+    return 0;
+}
+
+/** Maps file, read into memory where mmap is not available. Returns 0 or error. */
+int opsbin_open(opsbin* b, const char* filename) {
+#ifndef _WIN32
+    struct stat st;
+    int         fd, ret;
+
+    memset(b, 0, sizeof(opsbin));
+    if((fd = open(filename, O_RDONLY)) < 0) return OPSBIN_IO;
+    if(fstat(fd, &st) < 0) {
+        close(fd);
+        return OPSBIN_IO;
+    }
+    if(st.st_size == 0) {
+        close(fd);
+        return OPSBIN_FORMAT;
+    }
+    b->size = st.st_size;
+    b->base = mmap(NULL, b->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(b->base == MAP_FAILED) {
+        b->base = NULL;
+        return OPSBIN_IO;
+    }
+    if((ret = opsbin_map(b, b->base, b->size)) < 0) {
+        munmap(b->base, b->size);
+        b->base = NULL;
+    }
+    return ret;
+#else
+    FILE*   f;
+    long    size;
+    int     ret;
+
+    memset(b, 0, sizeof(opsbin));
+    if(!(f = fopen(filename, "rb"))) return OPSBIN_IO;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if(size <= 0 || !(b->base = malloc(size)) || fread(b->base, 1, size, f) != (size_t)size) {
+        fclose(f);
+        free(b->base);
+        b->base = NULL;
+        return size == 0 ? OPSBIN_FORMAT : OPSBIN_IO;
+    }
+    fclose(f);
+    b->size = size;
+    if((ret = opsbin_map(b, b->base, b->size)) < 0) {
+        free(b->base);
+        b->base = NULL;
+    }
+    return ret;
+#endif
+}
+
+void opsbin_close(opsbin* b) {
+    if(!b->base) return;
+#ifndef _WIN32
+    munmap(b->base, b->size);
+#else
+    free(b->base);
+#endif
+    b->base = NULL;
+}
+
+/** Text of operation i. */
+const char* opsbin_text(const opsbin* b, uint32_t i) {
+    return b->text[i] < b->h->strings_size ? b->strings + b->text[i] : "";
+}
+
+/** Label of operation i, NULL if it has none. */
+const char* opsbin_label(const opsbin* b, uint32_t i) {
+    return b->label[i] < b->h->strings_size ? b->strings + b->label[i] : NULL;
+}
+
+/** Hex dump line of operation i, same as sops_dump. */
+void opsbin_dump_op(const opsbin* b, uint32_t i, FILE* f) {
+    const uint8_t*  c = b->code + i * 3;
+    const char*     name = opsbin_text(b, i);
+
+    switch(b->len[i]) {
+        case 1:
+            fprintf(f, "[0x%.8X] 0x%.2X           %s\n", b->off[i], c[0], name);
+            break;
+        case 2:
+            if(strstr(name, "JR"))
+                fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X      %s ; 0x%X\n", b->off[i], c[0], c[1], name,
+                    b->target[i] == OPSBIN_NONE ? 0 : b->target[i]);
+            else
+                fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X      %s\n", b->off[i], c[0], c[1], name);
+            break;
+        case 3:
+            fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X 0x%.2X %s\n", b->off[i], c[0], c[1], c[2], name);
+            break;
+    }
+}
+
+#endif
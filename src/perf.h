@@ -0,0 +1,110 @@
+#ifndef __GB_DASM_PERF_H__
+#define __GB_DASM_PERF_H__
+
+/* perf.h: Hardware performance counters per phase, Linux perf_event_open.
+
+   Every counter is opened on its own, so the ones the kernel or CPU doesn't
+   provide are reported as unavailable and the rest still work. Counters are
+   inherited by threads created later and scaled when multiplexed. */
+
+#include "stdinc.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define PERF_COUNTERS   6
+#define PERF_PHASES     8
+
+static const char* PERF_NAMES[PERF_COUNTERS] = {
+    "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses", "page-faults"
+};
+
+typedef struct perf {
+    /** Counter file descriptors, -1 when unavailable. */
+    int         fd[PERF_COUNTERS];
+    /** Value, time enabled and time running at phase begin. */
+    uint64_t    start[PERF_COUNTERS][3];
+    /** Scaled counts per phase. */
+    uint64_t    value[PERF_PHASES][PERF_COUNTERS];
+    int         available;
+} perf;
+
+#ifdef __linux__
+int perf_event(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/** Opens counters, returns number of available ones. */
+int perf_open(perf* p) {
+    int i;
+
+    memset(p, 0, sizeof(perf));
+    for(i=0; i<PERF_COUNTERS; i++) p->fd[i] = -1;
+#ifdef __linux__
+    p->fd[0] = perf_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    p->fd[1] = perf_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    p->fd[2] = perf_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    p->fd[3] = perf_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    p->fd[4] = perf_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    p->fd[5] = perf_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#endif
+    for(i=0; i<PERF_COUNTERS; i++)
+        if(p->fd[i] >= 0) p->available++;
+    return p->available;
+}
+
+void perf_close(perf* p) {
+#ifdef __linux__
+    int i;
+    for(i=0; i<PERF_COUNTERS; i++)
+        if(p->fd[i] >= 0) close(p->fd[i]);
+#endif
+}
+
+/** Value, time enabled and time running, 0 if counter can't be read. */
+int perf_read(const perf* p, int i, uint64_t* v) {
+#ifdef __linux__
+    if(p->fd[i] >= 0 && read(p->fd[i], v, 3 * sizeof(uint64_t)) == 3 * sizeof(uint64_t))
+        return 1;
+#endif
+    return 0;
+}
+
+void perf_begin(perf* p) {
+    int i;
+    for(i=0; i<PERF_COUNTERS; i++)
+        if(!perf_read(p, i, p->start[i])) p->start[i][0] = p->start[i][1] = p->start[i][2] = 0;
+}
+
+void perf_end(perf* p, int phase) {
+    uint64_t    v[3];
+    double      delta;
+    int         i;
+
+    for(i=0; i<PERF_COUNTERS; i++) {
+        if(!perf_read(p, i, v)) continue;
+        delta = (double)(v[0] - p->start[i][0]);
+        /* multiplexed counter ran only part of the time */
+        if(v[2] - p->start[i][2] > 0 && v[2] - p->start[i][2] < v[1] - p->start[i][1])
+            delta *= (double)(v[1] - p->start[i][1]) / (v[2] - p->start[i][2]);
+        p->value[phase][i] += (uint64_t)delta;
+    }
+}
+
+#endif
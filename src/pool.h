@@ -0,0 +1,190 @@
+#ifndef __GB_DASM_POOL_H__
+#define __GB_DASM_POOL_H__
+
+/* pool.h: Thread pool, tasks may submit further tasks. */
+
+#include "stdinc.h"
+#include "mem.h"
+#include "events.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/** Task run by worker. */
+typedef void (*pool_task)(void* arg);
+
+typedef struct pool_job {
+    pool_task   fn;
+    void*       arg;
+} pool_job;
+
+typedef struct pool {
+    /** Number of worker threads, 0 runs tasks in pool_wait. */
+    int         threads;
+    /** Queued tasks, ring buffer. */
+    pool_job*   queue;
+    int         head;
+    int         len;
+    int         reserved;
+    /** Tasks being run. */
+    int         active;
+    int         quit;
+    /** Span per task when tracing, NULL otherwise. */
+    events*     trace;
+#ifndef _WIN32
+    pthread_t*      tid;
+    pthread_mutex_t lock;
+    pthread_cond_t  work;
+    pthread_cond_t  idle;
+#endif
+} pool;
+
+/** Number of online processors. */
+int pool_cpus(void) {
+#ifdef _WIN32
+    return 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/** Atomic decrement, returns new value. */
+int pool_dec(int* x) {
+#ifdef _WIN32
+    return --(*x);
+#else
+    return __sync_sub_and_fetch(x, 1);
+#endif
+}
+
+void pool_push(pool* p, pool_task fn, void* arg) {
+    if(p->len == p->reserved) {
+        pool_job* q = (pool_job*)mem_alloc(MEM_ANALYSIS, p->reserved * 2 * sizeof(pool_job));
+        int i;
+        for(i=0; i<p->len; i++)
+            q[i] = p->queue[(p->head + i) % p->reserved];
+        mem_free(p->queue);
+        p->queue = q;
+        p->head = 0;
+        p->reserved *= 2;
+    }
+    p->queue[(p->head + p->len) % p->reserved].fn = fn;
+    p->queue[(p->head + p->len) % p->reserved].arg = arg;
+    p->len++;
+}
+
+pool_job pool_pop(pool* p) {
+    pool_job job = p->queue[p->head];
+    p->head = (p->head + 1) % p->reserved;
+    p->len--;
+    return job;
+}
+
+void pool_run(pool* p, pool_job job) {
+    double t0;
+
+    if(!p->trace) {
+        job.fn(job.arg);
+        return;
+    }
+    t0 = events_now(p->trace);
+    job.fn(job.arg);
+    events_span(p->trace, "task", "worker", t0, -1);
+}
+
+#ifndef _WIN32
+void* pool_worker(void* arg) {
+    pool* p = (pool*)arg;
+    pool_job job;
+
+    pthread_mutex_lock(&p->lock);
+    while(1) {
+        while(!p->len && !p->quit)
+            pthread_cond_wait(&p->work, &p->lock);
+        if(!p->len) break;
+        job = pool_pop(p);
+        p->active++;
+        pthread_mutex_unlock(&p->lock);
+        pool_run(p, job);
+        pthread_mutex_lock(&p->lock);
+        if(--p->active == 0 && !p->len)
+            pthread_cond_broadcast(&p->idle);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+#endif
+
+pool* pool_create(int threads) {
+    pool* p;
+    int i;
+
+    p = (pool*)mem_calloc(MEM_ANALYSIS, 1, sizeof(pool));
+    p->reserved = 64;
+    p->queue = (pool_job*)mem_alloc(MEM_ANALYSIS, p->reserved * sizeof(pool_job));
+#ifdef _WIN32
+    threads = 0;
+#else
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->work, NULL);
+    pthread_cond_init(&p->idle, NULL);
+    p->tid = (pthread_t*)mem_alloc(MEM_ANALYSIS, (threads > 0 ? threads : 1) * sizeof(pthread_t));
+    for(i=0; i<threads; i++)
+        if(pthread_create(&p->tid[i], NULL, pool_worker, p) != 0) break;
+    threads = i;
+#endif
+    p->threads = threads;
+    return p;
+}
+
+void pool_submit(pool* p, pool_task fn, void* arg) {
+#ifndef _WIN32
+    pthread_mutex_lock(&p->lock);
+    pool_push(p, fn, arg);
+    pthread_cond_signal(&p->work);
+    pthread_mutex_unlock(&p->lock);
+#else
+    pool_push(p, fn, arg);
+#endif
+}
+
+/** Waits until all tasks, including submitted meanwhile, are done. */
+void pool_wait(pool* p) {
+    if(p->threads == 0) {
+        while(p->len) {
+            pool_job job = pool_pop(p);
+            pool_run(p, job);
+        }
+        return;
+    }
+#ifndef _WIN32
+    pthread_mutex_lock(&p->lock);
+    while(p->len || p->active)
+        pthread_cond_wait(&p->idle, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+#endif
+}
+
+void pool_free(pool* p) {
+#ifndef _WIN32
+    int i;
+
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->work);
+    pthread_mutex_unlock(&p->lock);
+    for(i=0; i<p->threads; i++)
+        pthread_join(p->tid[i], NULL);
+    mem_free(p->tid);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->work);
+    pthread_cond_destroy(&p->idle);
+#endif
+    mem_free(p->queue);
+    mem_free(p);
+}
+
+#endif
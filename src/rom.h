@@ -4,6 +4,7 @@
 /* rom.h: GameBoy ROM content loading. */
 
 #include "stdinc.h"
+#include "mem.h"
 #include "header.h"
 
 typedef struct rom {
@@ -25,17 +26,17 @@ rom* rom_load(const char* filename) {
         fseek(f, 0, SEEK_END);
         total = ftell(f);
         if(total > 0) {
-            r = (rom*)malloc(sizeof(rom));
-            r->raw = (uint8_t*)malloc(total);
+            r = (rom*)mem_alloc(MEM_ROM, sizeof(rom));
+            r->raw = (uint8_t*)mem_alloc(MEM_ROM, total);
             r->total = total;
             fseek(f, 0, SEEK_SET);
             if(fread(r->raw, 1, total, f) != total) {
-                free(r->raw);
-                free(r);
+                mem_free(r->raw);
+                mem_free(r);
                 fclose(f);
                 return NULL;
             }
-            r->filename = strdup(filename);
+            r->filename = mem_strdup(MEM_ROM, filename);
         }
         fclose(f);
     }
@@ -44,9 +45,9 @@ rom* rom_load(const char* filename) {
 }
 
 void rom_free(rom* r) {
-    if(r->filename) free(r->filename);
-    if(r->raw) free(r->raw);
-    free(r);
+    if(r->filename) mem_free(r->filename);
+    if(r->raw) mem_free(r->raw);
+    mem_free(r);
 }
 
 cart_header* rom_header(rom* r) {
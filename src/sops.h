@@ -1,9 +1,12 @@
 #ifndef __GB_DASM_SOPS_H__
 #define __GB_DASM_SOPS_H__
 
-/** sops.h: Operations sorted by address. Sorted linked list. */
+/** sops.h: Operations sorted by address. Sorted linked list, indexed by offset. */
 
 #include "rom.h"
+#include "sym.h"
+#include "hex.h"
+#include "fill.h"
 
 /** This operation is destination of a jump instruction. */
 #define OP_FLAG_JMP_ADDR    0x01
@@ -11,6 +14,17 @@
 #define OP_FLAG_CALL_ADDR   0x02
 /** Jump/call instruction. */
 #define OP_FLAG_IS_JUMP     0x04
+/** Data word, jump table entry. */
+#define OP_FLAG_IS_DATA     0x08
+
+/** Data is printed as DB lines instead of INCBIN of ROM file, --data-as-db. */
+int sops_db;
+
+/** Fill regions printed as REPT blocks, --fill, NULL when not scanned. */
+const fills* sops_fills;
+
+/** Bytes of data formatted at once. */
+#define SOPS_DB_CHUNK   4096
 
 /** Operation. */
 typedef struct op {
@@ -34,7 +48,7 @@ op* op_create(uint32_t off, const uint8_t* code, uint8_t len, const char* name)
     op* oper;
     int i;
 
-    oper = (op*)malloc(sizeof(op));
+    oper = (op*)mem_alloc(MEM_OPS, sizeof(op));
     oper->off = off;
     for(i=0; i<len; i++) 
         oper->code[i] = code[i];
@@ -52,188 +66,506 @@ void sops_free(op* head) {
         while(tmp) {
             sw = tmp;
             tmp = tmp->next;
-            free(sw);
+            mem_free(sw);
         }
     }
 }
 
-op* sops_add(op* head, op* oper) {
-    op* new_op = op_create(oper->off, oper->code, oper->len, oper->name);
-    if(head) {
-        op* tmp, *prev;
-        tmp = head;
-        prev = NULL;
+/* Byte ownership states. */
+#define OWN_UNKNOWN 0x00
+#define OWN_CODE    0x01 /* first byte of instruction */
+#define OWN_CONT    0x02 /* operand byte of instruction */
+#define OWN_DATA    0x03 /* byte of data word */
+#define OWN_STATE   0x03
+/** Instruction was branched to, not reached from the previous one. */
+#define OWN_TARGET  0x04
 
-        while(tmp) {
-            if(oper->off < tmp->off) {
-                if(prev) {
-                    prev->next = new_op;
-                    new_op->next = tmp;
-                    return head;
-                } else {
-                    new_op->next = head;
-                    head = new_op;
-                    return head;
-                }
-            } else if(oper->off == tmp->off) {
-                return head; /* already on list */
-            }
-            prev = tmp;
-            tmp = tmp->next;
-        }
+/** Operations by offset, list lookups and sorted insertion don't walk the list. */
+typedef struct sops_idx {
+    uint32_t    total;
+    /** Operation starts, bit per offset. */
+    uint64_t*   starts;
+    /** Owner of every byte, OWN_* state and flags. */
+    uint8_t*    own;
+    /** Operations, pages of 256 offsets allocated on first use. */
+    op***       pages;
+    /** Changes of operations per bank, added, removed or flags cleared. */
+    uint32_t*   gens;
+} sops_idx;
 
-        prev->next = new_op;
-    } else
-        head = new_op;
+void sops_idx_init(sops_idx* x, uint32_t total) {
+    x->total = total;
+    x->starts = (uint64_t*)mem_calloc(MEM_OPS, (total >> 6) + 1, sizeof(uint64_t));
+    x->own = (uint8_t*)mem_calloc(MEM_OPS, total + 1, 1);
+    x->pages = (op***)mem_calloc(MEM_OPS, (total >> 8) + 1, sizeof(op**));
+    x->gens = (uint32_t*)mem_calloc(MEM_OPS, (total >> 14) + 1, sizeof(uint32_t));
+}
 
-    return head;
+void sops_idx_free(sops_idx* x) {
+    uint32_t i;
+
+    for(i=0; i<=(x->total >> 8); i++)
+        if(x->pages[i]) mem_free(x->pages[i]);
+    mem_free(x->pages);
+    mem_free(x->starts);
+    mem_free(x->own);
+    mem_free(x->gens);
 }
 
-op* sops_get(op* head, uint32_t addr) {
-    op* tmp = head;
-    while(tmp) {
-        if(tmp->off == addr) return tmp;
-        tmp = tmp->next;
+op* sops_get(const sops_idx* x, uint32_t addr) {
+    if(addr >= x->total || !x->pages[addr >> 8]) return NULL;
+    return x->pages[addr >> 8][addr & 0xFF];
+}
+
+/** Closest operation before offset, NULL if there is none. */
+op* sops_prev(const sops_idx* x, uint32_t addr) {
+    int      w = addr >> 6;
+    uint64_t bits = x->starts[w] & ((1ULL << (addr & 63)) - 1);
+
+    while(!bits) {
+        if(--w < 0) return NULL;
+        bits = x->starts[w];
     }
-    return NULL;
+    return sops_get(x, ((uint32_t)w << 6) + 63 - clz64(bits));
 }
 
-int sops_contains(op* head, uint32_t addr) {
-    return (sops_get(head, addr) != NULL);
+/** Closest operation after offset and before limit, NULL if there is none. */
+op* sops_next(const sops_idx* x, uint32_t addr, uint32_t limit) {
+    uint32_t w = (addr + 1) >> 6;
+    uint64_t bits;
+
+    if(limit > x->total) limit = x->total;
+    if(addr + 1 >= limit) return NULL;
+    bits = x->starts[w] & (~0ULL << ((addr + 1) & 63));
+    while(!bits) {
+        if(++w << 6 >= limit) return NULL;
+        bits = x->starts[w];
+    }
+    addr = (w << 6) + ctz64(bits);
+    return addr < limit ? sops_get(x, addr) : NULL;
 }
 
-void sops_set_flag(op* head, uint32_t addr, uint8_t flag) {
-    op* tmp = head;
-    while(tmp) {
-        if(tmp->off == addr) {
-            tmp->flags |= flag;
-            return;
-        }
-        tmp = tmp->next;
+/** Marks bytes of operation, OWN_TARGET of the first one is kept. */
+void sops_own(sops_idx* x, uint32_t off, uint32_t len, uint8_t state) {
+    uint32_t i;
+
+    for(i=0; i<len && off+i < x->total; i++)
+        x->own[off+i] = i == 0 && state == OWN_CODE ? (x->own[off] & OWN_TARGET) | OWN_CODE :
+            (state == OWN_CODE ? OWN_CONT : state);
+}
+
+/** Start of operation owning byte, -1 for unknown byte. */
+int sops_owner(const sops_idx* x, uint32_t addr) {
+    int i;
+
+    if(addr >= x->total || (x->own[addr] & OWN_STATE) == OWN_UNKNOWN) return -1;
+    for(i=0; i<3 && (uint32_t)i <= addr; i++)
+        if((x->starts[(addr-i) >> 6] >> ((addr-i) & 63)) & 1) return addr - i;
+    return -1;
+}
+
+/** Operation owning any byte of the len bytes from offset, other than one starting there.
+    Returns its start, -1 if the bytes are free. */
+int sops_overlap(const sops_idx* x, uint32_t off, uint32_t len) {
+    uint32_t i;
+    uint8_t  state;
+
+    for(i=0; i<len && off+i < x->total; i++) {
+        state = x->own[off+i] & OWN_STATE;
+        if(state == OWN_UNKNOWN || (i == 0 && state == OWN_CODE)) continue;
+        return sops_owner(x, off+i);
+    }
+    return -1;
+}
+
+/** Removes operation starting at offset from list, returns new head. */
+op* sops_remove(op* head, sops_idx* x, uint32_t off) {
+    op* oper = sops_get(x, off);
+    op* prev;
+    uint32_t i;
+
+    if(!oper) return head;
+    if((prev = sops_prev(x, off)))
+        prev->next = oper->next;
+    else
+        head = oper->next;
+    x->pages[off >> 8][off & 0xFF] = NULL;
+    x->starts[off >> 6] &= ~(1ULL << (off & 63));
+    for(i=0; i<oper->len && off+i < x->total; i++)
+        x->own[off+i] &= OWN_TARGET;
+    x->gens[off >> 14]++;
+    mem_free(oper);
+    return head;
+}
+
+/** Adds operation to list, which owns it afterwards, returns new head.
+    Operation is freed if its offset is already on list. */
+op* sops_add(op* head, sops_idx* x, op* oper) {
+    op* prev;
+
+    if(oper->off >= x->total || sops_get(x, oper->off)) { /* already on list */
+        mem_free(oper);
+        return head;
+    }
+
+    if(!x->pages[oper->off >> 8])
+        x->pages[oper->off >> 8] = (op**)mem_calloc(MEM_OPS, 256, sizeof(op*));
+    x->pages[oper->off >> 8][oper->off & 0xFF] = oper;
+    x->starts[oper->off >> 6] |= 1ULL << (oper->off & 63);
+    sops_own(x, oper->off, oper->len, (oper->flags & OP_FLAG_IS_DATA) ? OWN_DATA : OWN_CODE);
+    x->gens[oper->off >> 14]++;
+
+    if((prev = sops_prev(x, oper->off))) {
+        oper->next = prev->next;
+        prev->next = oper;
+    } else {
+        oper->next = head;
+        head = oper;
     }
+    return head;
+}
+
+int sops_contains(const sops_idx* x, uint32_t addr) {
+    return (sops_get(x, addr) != NULL);
+}
+
+void sops_set_flag(sops_idx* x, uint32_t addr, uint8_t flag) {
+    op* tmp = sops_get(x, addr);
+    if(tmp) tmp->flags |= flag;
+}
+
+/** Clears flag of operation, its bank counts as changed. */
+void sops_clear_flag(sops_idx* x, op* oper, uint8_t flag) {
+    if(!(oper->flags & flag)) return;
+    oper->flags &= ~flag;
+    x->gens[oper->off >> 14]++;
 }
 
 /** Use this after call or jump instruction. */
-void sops_set_jmp(op* head, uint32_t addr, uint32_t daddr) {
-    op* tmp = head;
-    while(tmp) {
-        if(tmp->off == addr) {
-            tmp->flags |= OP_FLAG_IS_JUMP;
-            tmp->addr = daddr;
-            return;
-        }
-        tmp = tmp->next;
+void sops_set_jmp(sops_idx* x, uint32_t addr, uint32_t daddr) {
+    op* tmp = sops_get(x, addr);
+    if(tmp) {
+        tmp->flags |= OP_FLAG_IS_JUMP;
+        tmp->addr = daddr;
+    }
+}
+
+/** Hex dump line of operation. */
+void sops_dump_op(FILE* f, const op* tmp) {
+    switch(tmp->len) {
+        case 1:
+            fprintf(f, "[0x%.8X] 0x%.2X           %s\n", 
+                tmp->off, tmp->code[0], tmp->name);
+            break;
+        case 2:
+            if(strstr(tmp->name, "JR")) {
+                fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X      %s ; 0x%X\n", 
+                    tmp->off, tmp->code[0], tmp->code[1], tmp->name, tmp->addr);
+            } else {
+                fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X      %s\n", 
+                    tmp->off, tmp->code[0], tmp->code[1], tmp->name);
+            }
+            break;
+        case 3:
+            fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X 0x%.2X %s\n", 
+                tmp->off, tmp->code[0], tmp->code[1], tmp->code[2], tmp->name);
+            break;
     }
 }
 
 /** Hex dump. */
 void sops_dump(op* head, FILE* f) {
-    op* tmp = head;
-    while(tmp) {
-        switch(tmp->len) {
-            case 1:
-                fprintf(f, "[0x%.8X] 0x%.2X           %s\n", 
-                    tmp->off, tmp->code[0], tmp->name);
-                break;
-            case 2:
-                if(strstr(tmp->name, "JR")) {
-                    fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X      %s ; 0x%X\n", 
-                        tmp->off, tmp->code[0], tmp->code[1], tmp->name, tmp->addr);
-                } else {
-                    fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X      %s\n", 
-                        tmp->off, tmp->code[0], tmp->code[1], tmp->name);
-                }
-                break;
-            case 3:
-                fprintf(f, "[0x%.8X] 0x%.2X 0x%.2X 0x%.2X %s\n", 
-                    tmp->off, tmp->code[0], tmp->code[1], tmp->code[2], tmp->name);
-                break;
+    op* tmp;
+    for(tmp = head; tmp; tmp = tmp->next)
+        sops_dump_op(f, tmp);
+}
+
+/** Position in imported symbols while generated labels are merged in. */
+typedef struct sops_sym_cursor {
+    sym*    sorted;
+    int     i;
+} sops_sym_cursor;
+
+void sops_sym_begin(sops_sym_cursor* c, FILE* f, const syms* s) {
+    c->sorted = syms_sorted(s);
+    c->i = 0;
+    fprintf(f, "; File generated by gb-disasm\n");
+}
+
+/** Imported symbols up to operation, then its generated labels. */
+void sops_sym_op(sops_sym_cursor* c, FILE* f, const syms* s, const op* tmp) {
+    uint32_t    key;
+    int         n = s->len;
+
+    if(!(tmp->flags & (OP_FLAG_JMP_ADDR | OP_FLAG_CALL_ADDR))) return;
+    key = sym_key_phy(tmp->off);
+    for(; c->i < n && c->sorted[c->i].key <= key; c->i++)
+        fprintf(f, "%.2X:%.4X %s\n", SYM_BANK(c->sorted[c->i].key), SYM_ADDR(c->sorted[c->i].key), 
+            s->names + c->sorted[c->i].name);
+    if(c->i && c->sorted[c->i-1].key == key) return; /* imported name wins */
+    if(tmp->flags & OP_FLAG_JMP_ADDR)
+        fprintf(f, "%.2X:%.4X jmp_%x\n", SYM_BANK(key), SYM_ADDR(key), tmp->off);
+    if(tmp->flags & OP_FLAG_CALL_ADDR)
+        fprintf(f, "%.2X:%.4X sub_%x\n", SYM_BANK(key), SYM_ADDR(key), tmp->off);
+}
+
+void sops_sym_end(sops_sym_cursor* c, FILE* f, const syms* s) {
+    for(; c->i < s->len; c->i++)
+        fprintf(f, "%.2X:%.4X %s\n", SYM_BANK(c->sorted[c->i].key), SYM_ADDR(c->sorted[c->i].key), 
+            s->names + c->sorted[c->i].name);
+    mem_free(c->sorted);
+}
+
+/** Symbols file, generated labels merged with imported symbols in one pass. */
+void sops_sym(op* head, FILE* f, const syms* s) {
+    sops_sym_cursor c;
+    op*             tmp;
+
+    sops_sym_begin(&c, f, s);
+    for(tmp = head; tmp; tmp = tmp->next)
+        sops_sym_op(&c, f, s, tmp);
+    sops_sym_end(&c, f, s);
+}
+
+/** Label at off, imported symbol or generated with prefix. */
+void sops_print_label(FILE* f, const syms* s, uint32_t off, const char* prefix) {
+    const char* name = syms_label(s, off);
+    if(name) 
+        fputs(name, f);
+    else
+        fprintf(f, "%s%x", prefix, off);
+}
+
+/** Imported symbol of 16-bit address operand, -1 if there is none. */
+int sops_sym_index(const syms* s, const op* o) {
+    uint16_t addr;
+    int      i;
+
+    if(!s || !s->len || o->len != 3) return -1;
+    /* symbol with the same address has the same value in any bank */
+    addr = o->code[1] | (o->code[2] << 8);
+    if(addr >= 0x8000) {
+        if((i = syms_index(s, 0, addr)) < 0) i = syms_index(s, 1, addr);
+    } else if(addr < 0x4000)
+        i = syms_index(s, 0, addr);
+    else
+        i = syms_index(s, o->off >= 0x4000 ? o->off / 0x4000 : 1, addr);
+    return i;
+}
+
+/** Operation name, address operand is replaced by imported symbol. */
+void sops_print_name(FILE* f, const syms* s, const op* o) {
+    char        hex[8];
+    const char* name;
+    const char* p;
+    int         i;
+
+    if(s && s->len) {
+        if((i = sops_sym_index(s, o)) >= 0) {
+            name = s->names + s->list[i].name;
+            sprintf(hex, "$%.4X", SYM_ADDR(s->list[i].key));
+            if((p = strstr(o->name, hex))) {
+                fprintf(f, "%.*s%s%s", (int)(p - o->name), o->name, name, p + 5);
+                return;
+            }
+        } else if(o->len == 2 && (o->code[0] == 0xE0 || o->code[0] == 0xF0)) {
+            /* LDH keeps 8-bit operand, symbol goes to comment */
+            name = syms_find(s, 0, 0xFF00 | o->code[1]);
+            if(name && (p = strstr(o->name, " ; "))) {
+                fprintf(f, "%.*s ; %s", (int)(p - o->name), o->name, name);
+                return;
+            }
         }
+    }
+    fputs(o->name, f);
+}
+
+/** EQU lines of RAM and register symbols sops_print_name puts into operations from head until
+    stop (excluded), ROM symbols are labels. Symbols are in load order, each once. */
+void sops_asm_equ(FILE* f, const syms* s, const op* head, const op* stop) {
+    uint8_t*    used;
+    const op*   o;
+    int         i, n = 0;
 
-        tmp = tmp->next;
+    if(!s || !s->len) return;
+    used = (uint8_t*)mem_calloc(MEM_OUTPUT, s->len, 1);
+    for(o = head; o != stop; o = o->next) {
+        if((o->flags & OP_FLAG_IS_JUMP) || (i = sops_sym_index(s, o)) < 0) continue;
+        if(SYM_ADDR(s->list[i].key) >= 0x8000 && !used[i]) {
+            used[i] = 1;
+            n++;
+        }
     }
+    for(i=0; i<s->len; i++)
+        if(used[i]) fprintf(f, "%s EQU $%.4X\n", s->names + s->list[i].name, SYM_ADDR(s->list[i].key));
+    if(n) fprintf(f, "\n");
+    mem_free(used);
 }
 
-/** Disassembled code. */
-void sops_asm(op* head, FILE* f, rom* r) {
+/** Label and instruction line of operation. */
+void sops_asm_op(FILE* f, const op* o, const syms* s) {
     char buff[16];
-    op* tmp = head;
-    uint32_t prev = 0;
 
-    fprintf(f, "SECTION \"rom0\", HOME[0]\n");
-    
-    while(tmp) {
-        /* print data */
-        if(tmp->off != prev) {
-            if(prev > tmp->off)
-                fprintf(f, "\t; Something is wrong here\n");
-            else {
-                int prev_bank = prev / 0x4000;
-                int tmp_bank = tmp->off / 0x4000;
-                if(prev_bank == tmp_bank) 
-                    fprintf(f, "\n\tINCBIN \"%s\",$%x,$%x-$%x\n", r->filename, prev, tmp->off, prev);
-                else {
-                    fprintf(f, "\n\tINCBIN \"%s\",$%x,$%x-$%x\n\n", 
-                        r->filename, prev, (prev_bank+1)*0x4000, prev);
-                    fprintf(f, "SECTION \"bank%d\",DATA,BANK[$%d]\n", 
-                        tmp_bank, tmp_bank);
-                    fprintf(f, "\n\tINCBIN \"%s\",$%x,$%x-$%x\n", 
-                        r->filename, (prev_bank+1)*0x4000, tmp->off, (prev_bank+1)*0x4000);
-                }
+    /* print imported symbol, or jump or call label */
+    if(syms_label(s, o->off)) {
+        fprintf(f, "%s:\n", syms_label(s, o->off));
+    } else {
+        if(o->flags & OP_FLAG_JMP_ADDR) 
+            fprintf(f, "jmp_%x:\n", o->off);
+        if(o->flags & OP_FLAG_CALL_ADDR)
+            fprintf(f, "sub_%x:\n", o->off);
+    }
+
+    /* print jump or call instruction */
+    if(o->flags & OP_FLAG_IS_JUMP) {
+        if(strstr(o->name, "CALL")) {
+            fprintf(f, "\tCALL ");
+            sops_print_label(f, s, o->addr, "sub_");
+            fprintf(f, "\n");
+        } else {
+            char* sep = strstr(o->name, ",");
+            if(sep) {
+                strcpy(buff, o->name);
+                buff[sep-o->name] = 0;
+                if(strstr(buff, " ")) /* conditional jump */
+                    fprintf(f, "\t%s,", buff);
+                else
+                    fprintf(f, "\t%s ", buff);
+                sops_print_label(f, s, o->addr, "jmp_");
+                fprintf(f, "\n");
+            } else {
+                sep = strstr(o->name, " ");
+                if(sep) {
+                    strcpy(buff, o->name);
+                    buff[sep-o->name] = 0;
+                    fprintf(f, "\t%s ", buff);
+                    sops_print_label(f, s, o->addr, "jmp_");
+                    fprintf(f, "\n");
+                } else
+                    fprintf(f, "\t%s ; Something went wrong\n", o->name);
             }
         }
-        
-        /* print jump or call label */
-        if(tmp->flags & OP_FLAG_JMP_ADDR) 
-            fprintf(f, "jmp_%x:\n", tmp->off);
-        if(tmp->flags & OP_FLAG_CALL_ADDR)
-            fprintf(f, "sub_%x:\n", tmp->off);
-
-        /* print jump or call instruction */
-        if(tmp->flags & OP_FLAG_IS_JUMP) {
-            if(strstr(tmp->name, "CALL"))
-                fprintf(f, "\tCALL sub_%x\n", tmp->addr);
+    } else {
+        fprintf(f, "\t");
+        sops_print_name(f, s, o);
+        fprintf(f, "\n");
+    }
+
+    if(strcmp(o->name, "RET") == 0) fprintf(f, "\n");
+}
+
+/** Bytes from offset until end offset (excluded), INCBIN line or DB lines. */
+void sops_asm_bytes(FILE* f, const rom* r, uint32_t from, uint32_t to) {
+    char        buff[HEX_DB_SIZE(SOPS_DB_CHUNK)];
+    uint32_t    n;
+
+    if(!sops_db) {
+        fprintf(f, "\tINCBIN \"%s\",$%x,$%x-$%x\n", r->filename, from, to, from);
+        return;
+    }
+    if(to > r->total) to = r->total;
+    for(; from < to; from += n) {
+        n = to - from < SOPS_DB_CHUNK ? to - from : SOPS_DB_CHUNK;
+        fwrite(buff, 1, hex_db(buff, r->raw + from, n), f);
+    }
+}
+
+/** Next fill region printed as REPT block in data from offset until end offset, region index
+    starts at fills_find of from. Bounds clipped by operations are set, NULL if there is none. */
+const fill* sops_data_fill(int* i, uint32_t from, uint32_t to, uint32_t* s, uint32_t* e) {
+    const fill* fl;
+
+    for(; sops_fills && *i < sops_fills->len && sops_fills->list[*i].off < to; (*i)++) {
+        fl = &sops_fills->list[*i];
+        *s = fl->off > from ? fl->off : from;
+        *e = fl->off + fl->len < to ? fl->off + fl->len : to;
+        /* clipped by operations */
+        if(*e - *s < sops_fills->min) continue;
+        (*i)++;
+        return fl;
+    }
+    return NULL;
+}
+
+/** Data from offset until end offset (excluded), fill regions in it are REPT blocks. */
+void sops_asm_data(FILE* f, const rom* r, uint32_t from, uint32_t to) {
+    const fill* fl;
+    uint32_t    s, e;
+    int         i;
+
+    if(!sops_fills) {
+        sops_asm_bytes(f, r, from, to);
+        return;
+    }
+    for(i = fills_find(sops_fills, from); (fl = sops_data_fill(&i, from, to, &s, &e)); ) {
+        if(s > from) sops_asm_bytes(f, r, from, s);
+        /* DS with fill value is rgbds 0.5+, which has no HOME and DATA sections used here */
+        fprintf(f, "\tREPT %u\n\tDB $%.2X\n\tENDR\n", e - s, fl->value);
+        from = e;
+    }
+    if(from < to) sops_asm_bytes(f, r, from, to);
+}
+
+/** Data between end of previous operation and operation, split at bank boundary. */
+void sops_asm_gap(uint32_t prev, const op* tmp, FILE* f, const rom* r) {
+    if(tmp->off != prev) {
+        if(prev > tmp->off)
+            fprintf(f, "\t; Something is wrong here\n");
+        else {
+            int prev_bank = prev / 0x4000;
+            int tmp_bank = tmp->off / 0x4000;
+            fprintf(f, "\n");
+            if(prev_bank == tmp_bank) 
+                sops_asm_data(f, r, prev, tmp->off);
             else {
-                char* sep = strstr(tmp->name, ",");
-                if(sep) {
-                    strcpy(buff, tmp->name);
-                    buff[sep-tmp->name] = 0;
-                    if(strstr(buff, " ")) /* conditional jump */
-                        fprintf(f, "\t%s,jmp_%x\n", buff, tmp->addr);
-                    else
-                        fprintf(f, "\t%s jmp_%x\n", buff, tmp->addr);
-                } else {
-                    sep = strstr(tmp->name, " ");
-                    if(sep) {
-                        strcpy(buff, tmp->name);
-                        buff[sep-tmp->name] = 0;
-                        fprintf(f, "\t%s jmp_%x\n", buff, tmp->addr);
-                    } else
-                        fprintf(f, "\t%s ; Something went wrong\n", tmp->name);
-                }
+                sops_asm_data(f, r, prev, (prev_bank+1)*0x4000);
+                fprintf(f, "\nSECTION \"bank%d\",DATA,BANK[$%d]\n\n", 
+                    tmp_bank, tmp_bank);
+                sops_asm_data(f, r, (prev_bank+1)*0x4000, tmp->off);
             }
-        } else {
-            fprintf(f, "\t%s\n", tmp->name);
         }
+    }
+}
 
-        if(strcmp(tmp->name, "RET") == 0) fprintf(f, "\n");
-        
+/** Lines of operations from head until stop (excluded), prev is the end of operation before head.
+    Returns end of last operation. */
+uint32_t sops_asm_range(const op* head, const op* stop, uint32_t prev, FILE* f, const rom* r, const syms* s) {
+    const op* tmp;
+
+    for(tmp = head; tmp != stop; tmp = tmp->next) {
+        /* print data */
+        sops_asm_gap(prev, tmp, f, r);
+        sops_asm_op(f, tmp, s);
         prev = tmp->off + tmp->len;
-        tmp = tmp->next;
     }
-    
+    return prev;
+}
+
+/** Data after last operation, prev is its end. */
+void sops_asm_tail(uint32_t prev, FILE* f, const rom* r) {
     /* add anything whats left */
     if(prev % 0x4000 != 0) {
         int prev_bank = prev / 0x4000;
-        fprintf(f, "\n\tINCBIN \"%s\",$%x,$%x-$%x\n", r->filename, prev, (prev_bank+1)*0x4000, prev);
+        fprintf(f, "\n");
+        sops_asm_data(f, r, prev, (prev_bank+1)*0x4000);
         
         /* fill to 32KB */
         if(prev_bank == 0) {
             fprintf(f, "\nSECTION \"bank1\",DATA,BANK[$1]\n");
-            fprintf(f, "\tINCBIN \"%s\",$4000,$4000\n", r->filename);
+            if(sops_db || sops_fills)
+                sops_asm_data(f, r, 0x4000, 0x8000);
+            else
+                fprintf(f, "\tINCBIN \"%s\",$4000,$4000\n", r->filename);
         }
     }
 }
 
+/** Disassembled code. */
+void sops_asm(op* head, FILE* f, rom* r, const syms* s) {
+    sops_asm_equ(f, s, head, NULL);
+    fprintf(f, "SECTION \"rom0\", HOME[0]\n");
+    sops_asm_tail(sops_asm_range(head, NULL, 0, f, r, s), f, r);
+}
+
 #endif
 
@@ -0,0 +1,432 @@
+#ifndef __GB_DASM_SPLIT_H__
+#define __GB_DASM_SPLIT_H__
+
+/* split.h: Assembly split into file per bank (bankNN.asm) with Makefile, for
+   parallel reassembly. Every ROM bank has its file, bank without code is its
+   data only. Banks are written on pool workers, labels used from other banks
+   are exported by defining file and imported by using file. */
+
+#include "sops.h"
+#include "pool.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#endif
+
+/** Label reference across banks. */
+typedef struct split_ref {
+    uint32_t    target;
+    uint32_t    from;
+    /** Call labels have sub_ prefix, others jmp_. */
+    uint32_t    call;
+} split_ref;
+
+typedef struct split_bank {
+    int         bank;
+    const op*   head;
+    const op*   stop;
+    /** Exports and imports, ranges in sorted references. */
+    int         exp_first;
+    int         exp_len;
+    int         imp_first;
+    int         imp_len;
+    const struct split* sp;
+    /** File is up to date, --stream. */
+    int         skip;
+    int         error;
+} split_bank;
+
+typedef struct split {
+    const char* dir;
+    rom         r;
+    const syms* s;
+    split_ref*  by_target;
+    split_ref*  by_from;
+    int         refs;
+} split;
+
+int split_cmp_target(const void* a, const void* b) {
+    const split_ref* x = (const split_ref*)a;
+    const split_ref* y = (const split_ref*)b;
+    if(x->target != y->target) return x->target < y->target ? -1 : 1;
+    if(x->call != y->call) return x->call < y->call ? -1 : 1;
+    return x->from < y->from ? -1 : (x->from > y->from);
+}
+
+int split_cmp_from(const void* a, const void* b) {
+    const split_ref* x = (const split_ref*)a;
+    const split_ref* y = (const split_ref*)b;
+    if(x->from != y->from) return x->from < y->from ? -1 : 1;
+    return split_cmp_target(a, b);
+}
+
+/** Target is labelled in output, as jump label, call label or imported symbol. */
+int split_labelled(const sops_idx* x, const syms* s, uint32_t target, int call) {
+    const op* t = sops_get(x, target);
+    if(!t) return 0;
+    if(syms_label(s, target)) return 1;
+    return (t->flags & (call ? OP_FLAG_CALL_ADDR : OP_FLAG_JMP_ADDR)) != 0;
+}
+
+/** Reference of operation to label in other bank, from jump, call, table word or imported
+    symbol operand. Returns 0 if operation has none. */
+int split_ref_of(const split* sp, const op* o, const sops_idx* x, split_ref* ref) {
+    uint32_t    target;
+    uint16_t    addr;
+    int         call = 0;
+
+    if(o->flags & OP_FLAG_IS_JUMP) {
+        target = o->addr;
+        call = strstr(o->name, "CALL") != NULL;
+    } else if(sp->s && sp->s->len && o->len == 3) {
+        /* same rule as sops_print_name */
+        addr = o->code[1] | (o->code[2] << 8);
+        if(addr >= 0x8000) return 0;
+        if(addr < 0x4000)
+            target = addr;
+        else
+            target = (o->off >= 0x4000 ? o->off / 0x4000 : 1) * 0x4000 + addr - 0x4000;
+        if(!syms_label(sp->s, target)) return 0;
+    } else
+        return 0;
+    if(target / 0x4000 == o->off / 0x4000 || !split_labelled(x, sp->s, target, call)) return 0;
+    ref->target = target;
+    ref->from = o->off / 0x4000;
+    ref->call = call;
+    return 1;
+}
+
+/** Label references crossing banks, sorted by target and by using bank. */
+int split_refs(split* sp, const op* head, const sops_idx* x) {
+    const op*   o;
+    int         n = 0, reserved = 1024;
+
+    sp->by_target = (split_ref*)mem_alloc(MEM_OUTPUT, reserved * sizeof(split_ref));
+    for(o = head; o; o = o->next) {
+        if(n == reserved) {
+            reserved *= 2;
+            sp->by_target = (split_ref*)mem_realloc(MEM_OUTPUT, sp->by_target, reserved * sizeof(split_ref));
+        }
+        n += split_ref_of(sp, o, x, &sp->by_target[n]);
+    }
+    sp->by_from = (split_ref*)mem_alloc(MEM_OUTPUT, (n + 1) * sizeof(split_ref));
+    memcpy(sp->by_from, sp->by_target, n * sizeof(split_ref));
+    qsort(sp->by_target, n, sizeof(split_ref), split_cmp_target);
+    qsort(sp->by_from, n, sizeof(split_ref), split_cmp_from);
+    sp->refs = n;
+    return n;
+}
+
+/** Label name of reference, imported symbol wins. */
+void split_label(FILE* f, const syms* s, const split_ref* ref) {
+    sops_print_label(f, s, ref->target, ref->call ? "sub_" : "jmp_");
+}
+
+void split_task(void* arg) {
+    split_bank*     b = (split_bank*)arg;
+    const split*    sp = b->sp;
+    char            name[1024];
+    uint32_t        prev = b->bank * 0x4000;
+    uint32_t        end = prev + 0x4000 < sp->r.total ? prev + 0x4000 : sp->r.total;
+    FILE*           f;
+    int             i;
+
+    sprintf(name, "%s/bank%.2X.asm", sp->dir, b->bank);
+    if(!(f = fopen(name, "w"))) {
+        b->error = 1;
+        return;
+    }
+    for(i = b->exp_first; i < b->exp_first + b->exp_len; i++) {
+        /* references are sorted, same label from several banks is exported once */
+        if(i > b->exp_first && sp->by_target[i].target == sp->by_target[i-1].target &&
+                sp->by_target[i].call == sp->by_target[i-1].call) continue;
+        fprintf(f, "\tEXPORT ");
+        split_label(f, sp->s, &sp->by_target[i]);
+        fprintf(f, "\n");
+    }
+    for(i = b->imp_first; i < b->imp_first + b->imp_len; i++) {
+        if(i > b->imp_first && sp->by_from[i].target == sp->by_from[i-1].target &&
+                sp->by_from[i].call == sp->by_from[i-1].call) continue;
+        fprintf(f, "\tIMPORT ");
+        split_label(f, sp->s, &sp->by_from[i]);
+        fprintf(f, "\n");
+    }
+    if(b->exp_len || b->imp_len) fprintf(f, "\n");
+    sops_asm_equ(f, sp->s, b->head, b->stop);
+
+    if(b->bank == 0)
+        fprintf(f, "SECTION \"rom0\", HOME[0]\n");
+    else
+        fprintf(f, "SECTION \"bank%d\",DATA,BANK[%d]\n", b->bank, b->bank);
+    prev = sops_asm_range(b->head, b->stop, prev, f, &sp->r, sp->s);
+    if(prev < end) {
+        fprintf(f, "\n");
+        sops_asm_data(f, &sp->r, prev, end);
+    }
+    /* file covers its bank and nothing more, instruction crossing bank end can't link */
+    if(fclose(f) != 0 || prev > end) b->error = 1;
+}
+
+/** Makefile assembling banks in parallel (make -j) and linking them. */
+int split_makefile(const split* sp, const split_bank* banks, int n) {
+    char        name[1024];
+    const char* base;
+    const char* dot;
+    FILE*       f;
+    int         i;
+
+    sprintf(name, "%s/Makefile", sp->dir);
+    if(!(f = fopen(name, "w"))) return -1;
+    base = strrchr(sp->r.filename, '/');
+    base = base ? base + 1 : sp->r.filename;
+    dot = strrchr(base, '.');
+    fprintf(f, "# Generated by gb-disasm, assembles banks in parallel with make -j.\n\n");
+    fprintf(f, "ROM = %.*s_reasm.gb\n", (int)(dot ? dot - base : (long)strlen(base)), base);
+    fprintf(f, "OBJS =");
+    for(i=0; i<n; i++)
+        fprintf(f, " bank%.2X.o", banks[i].bank);
+    fprintf(f, "\n\nall: $(ROM)\n\n");
+    fprintf(f, "$(ROM): $(OBJS)\n\trgblink -o $@ $(OBJS)\n\trgbfix -v -p 0 $@\n\n");
+    fprintf(f, "%%.o: %%.asm\n\trgbasm -o $@ $<\n\n");
+    fprintf(f, "clean:\n\trm -f $(OBJS) $(ROM)\n\n.PHONY: all clean\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+/** Directory and ROM path as seen from it, returns -1 on error. */
+int split_init(split* sp, const char* dir, const rom* r, const syms* s, char* path, int size) {
+#ifdef _WIN32
+    _mkdir(dir);
+    if(!_fullpath(path, r->filename, size)) return -1;
+#else
+    if(mkdir(dir, 0755) < 0 && errno != EEXIST) return -1;
+    if(size < PATH_MAX || !realpath(r->filename, path)) return -1;
+#endif
+    /* files are assembled in dir, ROM is included by absolute path */
+    memset(sp, 0, sizeof(split));
+    sp->dir = dir;
+    sp->r = *r;
+    sp->r.filename = path;
+    sp->s = s;
+    return 0;
+}
+
+/** Every ROM bank with its operations and references, so bank files cover whole ROM. */
+split_bank* split_plan(split* sp, op* head, const sops_idx* x, int* len) {
+    split_bank* banks;
+    const op*   o = head;
+    int         n = (sp->r.total + 0x3FFF) / 0x4000, i, j, k;
+
+    split_refs(sp, head, x);
+    banks = (split_bank*)mem_calloc(MEM_OUTPUT, n, sizeof(split_bank));
+    for(i=0; i<n; i++) {
+        banks[i].bank = i;
+        banks[i].head = o;
+        while(o && o->off < (uint32_t)(i + 1) * 0x4000) o = o->next;
+        /* same as head for bank without code */
+        banks[i].stop = o;
+    }
+
+    for(i=0, j=0, k=0; i<n; i++) {
+        banks[i].sp = sp;
+        while(j < sp->refs && sp->by_target[j].target / 0x4000 < (uint32_t)banks[i].bank) j++;
+        banks[i].exp_first = j;
+        while(j < sp->refs && sp->by_target[j].target / 0x4000 == (uint32_t)banks[i].bank) j++;
+        banks[i].exp_len = j - banks[i].exp_first;
+        while(k < sp->refs && sp->by_from[k].from < (uint32_t)banks[i].bank) k++;
+        banks[i].imp_first = k;
+        while(k < sp->refs && sp->by_from[k].from == (uint32_t)banks[i].bank) k++;
+        banks[i].imp_len = k - banks[i].imp_first;
+    }
+    *len = n;
+    return banks;
+}
+
+/** Writes bank files on pool, returns -1 if some could not be written. */
+int split_write(split_bank* banks, int n, int threads, events* ev) {
+    pool*   p;
+    int     i, ret = 0;
+
+    p = pool_create(threads);
+    p->trace = ev;
+    for(i=0; i<n; i++)
+        if(!banks[i].skip) pool_submit(p, split_task, &banks[i]);
+    pool_wait(p);
+    pool_free(p);
+    for(i=0; i<n; i++)
+        if(banks[i].error) ret = -1;
+    return ret;
+}
+
+void split_free(split* sp) {
+    mem_free(sp->by_target);
+    mem_free(sp->by_from);
+}
+
+/** Writes bankNN.asm files and Makefile to dir, returns -1 on error. */
+int split_banks(const char* dir, op* head, const sops_idx* x, const rom* r, const syms* s,
+        int threads, events* ev) {
+    split       sp;
+    split_bank* banks;
+    char        path[4096];
+    int         n, ret;
+
+    if(split_init(&sp, dir, r, s, path, sizeof(path)) < 0) return -1;
+    banks = split_plan(&sp, head, x, &n);
+    ret = split_write(banks, n, threads, ev);
+    if(split_makefile(&sp, banks, n) < 0) ret = -1;
+    mem_free(banks);
+    split_free(&sp);
+    return ret;
+}
+
+/* Streaming, --stream.
+
+   Bank file is written as soon as traversal seals the bank, when no pending
+   branch can continue in it. Code found later can still reach a written bank,
+   so every written bank keeps fingerprint of what its file was made from:
+   operations and labels count, changes of its operations counted by the index
+   and hash of its EXPORT and IMPORT labels. Banks without code are written at
+   the end.
+   Overlap conflicts can remove an operation and add other one, the change count
+   tells it from the same count. Labels are only ever added, so equal fingerprint
+   at the end means equal file, other banks are written again. */
+
+typedef struct split_seal {
+    int         written;
+    uint32_t    ops;
+    uint32_t    jmps;
+    uint32_t    calls;
+    uint32_t    gen;
+    uint64_t    hash;
+} split_seal;
+
+typedef struct split_stream {
+    split       sp;
+    char        path[4096];
+    split_seal* seals;
+    int         banks;
+    /** Banks written during traversal and written again at the end. */
+    int         streamed;
+    int         rewritten;
+} split_stream;
+
+/** Hash of labels in reference range, same labels as EXPORT/IMPORT lines. */
+uint64_t split_hash_refs(uint64_t h, const split_ref* refs, int first, int len) {
+    int i;
+
+    for(i = first; i < first + len; i++) {
+        if(i > first && refs[i].target == refs[i-1].target && refs[i].call == refs[i-1].call) continue;
+        h = (h ^ refs[i].target) * 1099511628211ULL;
+        h = (h ^ refs[i].call) * 1099511628211ULL;
+    }
+    return h;
+}
+
+void split_seal_of(const split_bank* b, const sops_idx* x, split_seal* seal) {
+    const split*    sp = b->sp;
+    const op*       o;
+
+    memset(seal, 0, sizeof(split_seal));
+    for(o = b->head; o != b->stop; o = o->next) {
+        seal->ops++;
+        if(o->flags & OP_FLAG_JMP_ADDR) seal->jmps++;
+        if(o->flags & OP_FLAG_CALL_ADDR) seal->calls++;
+    }
+    seal->gen = x->gens[b->bank];
+    seal->hash = split_hash_refs(14695981039346656037ULL, sp->by_target, b->exp_first, b->exp_len);
+    seal->hash = split_hash_refs(seal->hash * 31, sp->by_from, b->imp_first, b->imp_len);
+    seal->written = 1;
+}
+
+int split_stream_init(split_stream* st, const char* dir, const rom* r, const syms* s) {
+    if(split_init(&st->sp, dir, r, s, st->path, sizeof(st->path)) < 0) return -1;
+    st->banks = r->total / 0x4000 + 1;
+    st->seals = (split_seal*)mem_calloc(MEM_OUTPUT, st->banks, sizeof(split_seal));
+    st->streamed = 0;
+    st->rewritten = 0;
+    return 0;
+}
+
+/** Writes sealed bank, labels of its operations must be set. Exports come from bank 0 only,
+    other banks calling into it are found at the end. Returns -1 on error. */
+int split_stream_bank(split_stream* st, int bank, const sops_idx* x) {
+    split       part;
+    split_bank  b;
+    const op*   o;
+    uint32_t    lo = bank * 0x4000, hi = lo + 0x4000;
+    int         n = 0, reserved = 256;
+
+    if(bank <= 0 || bank >= st->banks || st->seals[bank].written) return 0;
+    if(!(o = sops_get(x, lo)) && !(o = sops_next(x, lo, hi))) return 0;
+
+    memset(&b, 0, sizeof(b));
+    b.bank = bank;
+    b.head = o;
+    for(; o && o->off < hi; o = o->next);
+    b.stop = o;
+    b.sp = &part;
+
+    /* exports first, then imports, both sorted as in split_refs */
+    part = st->sp;
+    part.by_target = (split_ref*)mem_alloc(MEM_OUTPUT, reserved * sizeof(split_ref));
+    for(o = sops_get(x, 0) ? sops_get(x, 0) : sops_next(x, 0, 0x4000); o && o->off < 0x4000; o = o->next) {
+        if(n == reserved) {
+            reserved *= 2;
+            part.by_target = (split_ref*)mem_realloc(MEM_OUTPUT, part.by_target, reserved * sizeof(split_ref));
+        }
+        if(split_ref_of(&part, o, x, &part.by_target[n]) && part.by_target[n].target / 0x4000 == (uint32_t)bank)
+            n++;
+    }
+    b.exp_len = n;
+    for(o = b.head; o != b.stop; o = o->next) {
+        if(n == reserved) {
+            reserved *= 2;
+            part.by_target = (split_ref*)mem_realloc(MEM_OUTPUT, part.by_target, reserved * sizeof(split_ref));
+        }
+        n += split_ref_of(&part, o, x, &part.by_target[n]);
+    }
+    b.imp_first = b.exp_len;
+    b.imp_len = n - b.exp_len;
+    qsort(part.by_target, b.exp_len, sizeof(split_ref), split_cmp_target);
+    qsort(part.by_target + b.imp_first, b.imp_len, sizeof(split_ref), split_cmp_from);
+    part.by_from = part.by_target;
+    part.refs = n;
+
+    split_task(&b);
+    split_seal_of(&b, x, &st->seals[bank]);
+    st->streamed++;
+    mem_free(part.by_target);
+    return b.error ? -1 : 0;
+}
+
+/** Writes banks not written yet or changed since, and Makefile. Returns -1 on error. */
+int split_stream_finish(split_stream* st, op* head, const sops_idx* x, int threads, events* ev) {
+    split_bank* banks;
+    split_seal  seal;
+    int         n, i, ret;
+
+    banks = split_plan(&st->sp, head, x, &n);
+    for(i=0; i<n; i++) {
+        if(banks[i].bank >= st->banks || !st->seals[banks[i].bank].written) continue;
+        split_seal_of(&banks[i], x, &seal);
+        if(memcmp(&seal, &st->seals[banks[i].bank], sizeof(split_seal)) == 0)
+            banks[i].skip = 1;
+        else
+            st->rewritten++;
+    }
+    ret = split_write(banks, n, threads, ev);
+    if(split_makefile(&st->sp, banks, n) < 0) ret = -1;
+    mem_free(banks);
+    return ret;
+}
+
+void split_stream_free(split_stream* st) {
+    split_free(&st->sp);
+    mem_free(st->seals);
+}
+
+#endif
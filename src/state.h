@@ -3,6 +3,8 @@
 
 /* stack.h: State stack implementation. */
 
+#include "mem.h"
+
 /** Bank and pc state after return from control instruction. */
 typedef struct state {
     uint16_t    pc;
@@ -12,7 +14,7 @@ typedef struct state {
 
 state* state_push(state* top, uint16_t pc, int bank) {
     state* el;
-    el = (state*)malloc(sizeof(state));
+    el = (state*)mem_alloc(MEM_WORKLIST, sizeof(state));
     el->pc = pc;
     el->bank = bank;
     el->prev = top;
@@ -22,7 +24,7 @@ state* state_push(state* top, uint16_t pc, int bank) {
 state* state_pop(state* top) {
     state* ret;
     ret = top->prev;
-    free(top);
+    mem_free(top);
     return ret;
 }
 
@@ -30,7 +32,7 @@ void state_free(state* top) {
     state* tmp;
     while(top) {
         tmp = top->prev;
-        free(top);
+        mem_free(top);
         top = tmp;
     }
 }
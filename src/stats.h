@@ -0,0 +1,176 @@
+#ifndef __GB_DASM_STATS_H__
+#define __GB_DASM_STATS_H__
+
+/* stats.h: Run statistics, phase times and traversal counters. */
+
+#include "stdinc.h"
+#include "perf.h"
+#include "events.h"
+
+#ifdef _WIN32
+#include <time.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+/* Phases. */
+#define STATS_LOAD      0
+#define STATS_TRAVERSE  1
+#define STATS_LABEL     2
+#define STATS_ANALYSIS  3
+#define STATS_EMIT      4
+#define STATS_PHASES    5
+
+static const char* STATS_PHASE_NAMES[STATS_PHASES] = {
+    "load", "traverse", "label", "analysis", "emit"
+};
+
+typedef struct stats {
+    /** Seconds per phase, phases may be timed in several parts. */
+    double      phase[STATS_PHASES];
+    double      started;
+    /** Decoded instructions and addresses rejected as already decoded. */
+    uint64_t    decoded;
+    uint64_t    revisits;
+    /** Branch worklist. */
+    uint64_t    pushes;
+    uint64_t    pops;
+    uint32_t    depth;
+    uint32_t    max_depth;
+    uint64_t    bank_switches;
+    uint64_t    unknown;
+    /** Jump, call and restart targets outside of ROM or end address. */
+    uint64_t    out_of_range;
+    /** Paths rejected in fill regions and bytes in them, --fill. */
+    uint64_t    fill_rejections;
+    uint32_t    fill_bytes;
+    /** Instructions overlapping decoded bytes. */
+    uint64_t    overlaps;
+    /** Code blocks found in gaps and followed, --classify. */
+    uint64_t    seeds;
+    /** Hardware counters per phase, NULL when not requested. */
+    perf*       counters;
+    /** Phase spans for --trace-events, NULL when not requested. */
+    events*     spans;
+    double      span_start;
+} stats;
+
+/** Monotonic time in seconds. */
+double stats_now(void) {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+void stats_begin(stats* s) {
+    if(s->counters) perf_begin(s->counters);
+    if(s->spans) s->span_start = events_now(s->spans);
+    s->started = stats_now();
+}
+
+void stats_end(stats* s, int phase) {
+    s->phase[phase] += stats_now() - s->started;
+    if(s->counters) perf_end(s->counters, phase);
+    if(s->spans) events_span(s->spans, STATS_PHASE_NAMES[phase], "phase", s->span_start, -1);
+}
+
+/** Peak resident memory in KB, 0 if unknown. */
+long stats_peak_kb(void) {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage ru;
+    if(getrusage(RUSAGE_SELF, &ru) < 0) return 0;
+    return ru.ru_maxrss;
+#endif
+}
+
+void stats_print(const stats* s, FILE* f) {
+    double total = 0;
+    int i, c;
+
+    fprintf(f, "Stats:\n");
+    for(i=0; i<STATS_PHASES; i++) {
+        fprintf(f, "  %-22s %12.3f ms\n", STATS_PHASE_NAMES[i], s->phase[i] * 1e3);
+        total += s->phase[i];
+    }
+    fprintf(f, "  %-22s %12.3f ms\n", "total", total * 1e3);
+    fprintf(f, "  %-22s %12llu\n", "decoded instructions", (unsigned long long)s->decoded);
+    fprintf(f, "  %-22s %12llu\n", "revisit rejections", (unsigned long long)s->revisits);
+    fprintf(f, "  %-22s %12llu\n", "worklist pushes", (unsigned long long)s->pushes);
+    fprintf(f, "  %-22s %12llu\n", "worklist pops", (unsigned long long)s->pops);
+    fprintf(f, "  %-22s %12u\n", "worklist max depth", s->max_depth);
+    fprintf(f, "  %-22s %12llu\n", "bank switches", (unsigned long long)s->bank_switches);
+    fprintf(f, "  %-22s %12llu\n", "unknown opcodes", (unsigned long long)s->unknown);
+    fprintf(f, "  %-22s %12llu\n", "out of range targets", (unsigned long long)s->out_of_range);
+    fprintf(f, "  %-22s %12llu\n", "fill rejections", (unsigned long long)s->fill_rejections);
+    fprintf(f, "  %-22s %12u\n", "fill bytes", s->fill_bytes);
+    fprintf(f, "  %-22s %12llu\n", "overlap conflicts", (unsigned long long)s->overlaps);
+    fprintf(f, "  %-22s %12llu\n", "classifier seeds", (unsigned long long)s->seeds);
+    fprintf(f, "  %-22s %12ld KB\n", "peak memory", stats_peak_kb());
+
+    if(!s->counters) return;
+    if(!s->counters->available) {
+        fprintf(f, "  performance counters unavailable\n");
+        return;
+    }
+    fprintf(f, "  %-14s", "counter");
+    for(i=0; i<STATS_PHASES; i++) fprintf(f, " %14s", STATS_PHASE_NAMES[i]);
+    fprintf(f, "\n");
+    for(c=0; c<PERF_COUNTERS; c++) {
+        fprintf(f, "  %-14s", PERF_NAMES[c]);
+        for(i=0; i<STATS_PHASES; i++) {
+            if(s->counters->fd[c] >= 0)
+                fprintf(f, " %14llu", (unsigned long long)s->counters->value[i][c]);
+            else
+                fprintf(f, " %14s", "n/a");
+        }
+        fprintf(f, "\n");
+    }
+}
+
+void stats_json(const stats* s, FILE* f) {
+    int i, c;
+
+    fprintf(f, "{\n  \"phases_ms\": {");
+    for(i=0; i<STATS_PHASES; i++)
+        fprintf(f, "%s\"%s\": %.3f", i ? ", " : "", STATS_PHASE_NAMES[i], s->phase[i] * 1e3);
+    fprintf(f, "},\n");
+    fprintf(f, "  \"decoded\": %llu,\n", (unsigned long long)s->decoded);
+    fprintf(f, "  \"revisits\": %llu,\n", (unsigned long long)s->revisits);
+    fprintf(f, "  \"worklist_pushes\": %llu,\n", (unsigned long long)s->pushes);
+    fprintf(f, "  \"worklist_pops\": %llu,\n", (unsigned long long)s->pops);
+    fprintf(f, "  \"worklist_max_depth\": %u,\n", s->max_depth);
+    fprintf(f, "  \"bank_switches\": %llu,\n", (unsigned long long)s->bank_switches);
+    fprintf(f, "  \"unknown_opcodes\": %llu,\n", (unsigned long long)s->unknown);
+    fprintf(f, "  \"out_of_range\": %llu,\n", (unsigned long long)s->out_of_range);
+    fprintf(f, "  \"fill_rejections\": %llu,\n", (unsigned long long)s->fill_rejections);
+    fprintf(f, "  \"fill_bytes\": %u,\n", s->fill_bytes);
+    fprintf(f, "  \"overlaps\": %llu,\n", (unsigned long long)s->overlaps);
+    fprintf(f, "  \"seeds\": %llu,\n", (unsigned long long)s->seeds);
+    fprintf(f, "  \"peak_memory_kb\": %ld", stats_peak_kb());
+    if(s->counters) {
+        fprintf(f, ",\n  \"perf\": {");
+        for(c=0; c<PERF_COUNTERS; c++) {
+            fprintf(f, "%s\n    \"%s\": ", c ? "," : "", PERF_NAMES[c]);
+            if(s->counters->fd[c] < 0) {
+                fprintf(f, "null");
+                continue;
+            }
+            fprintf(f, "{");
+            for(i=0; i<STATS_PHASES; i++)
+                fprintf(f, "%s\"%s\": %llu", i ? ", " : "", STATS_PHASE_NAMES[i],
+                    (unsigned long long)s->counters->value[i][c]);
+            fprintf(f, "}");
+        }
+        fprintf(f, "\n  }");
+    }
+    fprintf(f, "\n}\n");
+}
+
+#endif
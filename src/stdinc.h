@@ -10,6 +10,41 @@
 typedef unsigned char   uint8_t;
 typedef unsigned short  uint16_t;
 typedef unsigned int    uint32_t;
+typedef unsigned long long uint64_t;
+
+/** Number of bits set. */
+#ifdef _MSC_VER
+static int popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+}
+
+/** Number of trailing zero bits, x must not be 0. */
+static int ctz64(uint64_t x) {
+    int n = 0;
+    while(!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+
+/** Number of leading zero bits, x must not be 0. */
+static int clz64(uint64_t x) {
+    int n = 0;
+    while(!(x >> 63)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
+#else
+#define popcount64(x) __builtin_popcountll(x)
+#define ctz64(x) __builtin_ctzll(x)
+#define clz64(x) __builtin_clzll(x)
+#endif
 
 #endif
 
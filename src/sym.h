@@ -0,0 +1,179 @@
+#ifndef __GB_DASM_SYM_H__
+#define __GB_DASM_SYM_H__
+
+/* sym.h: Symbols (rgbds/BGB .sym files), hashed by bank and address. */
+
+#include "stdinc.h"
+#include "mem.h"
+
+/** Symbol, name is offset in names buffer. */
+typedef struct sym {
+    uint32_t    key;
+    uint32_t    name;
+} sym;
+
+/** Symbols in load order with open addressing hash table of indexes (+1, 0 is empty slot). */
+typedef struct syms {
+    sym*        list;
+    int         len;
+    int         reserved;
+    uint32_t*   table;
+    int         bits;
+    char*       names;
+    uint32_t    names_len;
+    uint32_t    names_reserved;
+} syms;
+
+#define SYM_KEY(bank, addr) (((uint32_t)(bank) << 16) | (addr))
+#define SYM_BANK(key)       ((key) >> 16)
+#define SYM_ADDR(key)       ((key) & 0xFFFF)
+
+void syms_init(syms* s) {
+    s->len = 0;
+    s->reserved = 1024;
+    s->list = (sym*)mem_alloc(MEM_SYMBOLS, s->reserved * sizeof(sym));
+    s->bits = 11;
+    s->table = (uint32_t*)mem_calloc(MEM_SYMBOLS, 1 << s->bits, sizeof(uint32_t));
+    s->names_len = 0;
+    s->names_reserved = 16384;
+    s->names = (char*)mem_alloc(MEM_SYMBOLS, s->names_reserved);
+}
+
+void syms_free(syms* s) {
+    if(s->list) mem_free(s->list);
+    if(s->table) mem_free(s->table);
+    if(s->names) mem_free(s->names);
+}
+
+uint32_t syms_slot(const syms* s, uint32_t key) {
+    return (key * 2654435761U) >> (32 - s->bits);
+}
+
+/** Symbol index, -1 if not found. */
+int syms_index(const syms* s, int bank, uint16_t addr) {
+    uint32_t key = SYM_KEY(bank, addr);
+    uint32_t mask = (1 << s->bits) - 1;
+    uint32_t i;
+
+    for(i = syms_slot(s, key); s->table[i]; i = (i + 1) & mask)
+        if(s->list[s->table[i] - 1].key == key) return s->table[i] - 1;
+    return -1;
+}
+
+const char* syms_find(const syms* s, int bank, uint16_t addr) {
+    int i;
+    if(!s || !s->len) return NULL;
+    i = syms_index(s, bank, addr);
+    return i < 0 ? NULL : s->names + s->list[i].name;
+}
+
+/** Bank and address of physical ROM offset. */
+uint32_t sym_key_phy(uint32_t off) {
+    if(off < 0x4000) return SYM_KEY(0, off);
+    return SYM_KEY(off / 0x4000, 0x4000 + (off % 0x4000));
+}
+
+/** Symbol at physical ROM offset. */
+const char* syms_label(const syms* s, uint32_t off) {
+    uint32_t key = sym_key_phy(off);
+    return syms_find(s, SYM_BANK(key), SYM_ADDR(key));
+}
+
+int sym_cmp(const void* a, const void* b) {
+    uint32_t ka = ((const sym*)a)->key;
+    uint32_t kb = ((const sym*)b)->key;
+    return ka < kb ? -1 : (ka > kb);
+}
+
+/** Copy of symbols sorted by bank and address. */
+sym* syms_sorted(const syms* s) {
+    sym* sorted = (sym*)mem_alloc(MEM_SYMBOLS, (s->len + 1) * sizeof(sym));
+    memcpy(sorted, s->list, s->len * sizeof(sym));
+    qsort(sorted, s->len, sizeof(sym), sym_cmp);
+    return sorted;
+}
+
+/** Doubles hash table when half full. */
+void syms_grow(syms* s) {
+    uint32_t mask, i, j;
+
+    s->bits++;
+    mem_free(s->table);
+    s->table = (uint32_t*)mem_calloc(MEM_SYMBOLS, 1 << s->bits, sizeof(uint32_t));
+    mask = (1 << s->bits) - 1;
+    for(j=0; j<(uint32_t)s->len; j++) {
+        for(i = syms_slot(s, s->list[j].key); s->table[i]; i = (i + 1) & mask);
+        s->table[i] = j + 1;
+    }
+}
+
+/** Adds symbol, the first name at given bank and address is kept. */
+void syms_add(syms* s, int bank, uint16_t addr, const char* name, int len) {
+    uint32_t key = SYM_KEY(bank, addr);
+    uint32_t mask = (1 << s->bits) - 1;
+    uint32_t i;
+
+    for(i = syms_slot(s, key); s->table[i]; i = (i + 1) & mask)
+        if(s->list[s->table[i] - 1].key == key) return;
+
+    if(s->len == s->reserved) {
+        s->reserved <<= 1;
+        s->list = (sym*)mem_realloc(MEM_SYMBOLS, s->list, s->reserved * sizeof(sym));
+    }
+    while(s->names_len + len + 1 > s->names_reserved) {
+        s->names_reserved <<= 1;
+        s->names = (char*)mem_realloc(MEM_SYMBOLS, s->names, s->names_reserved);
+    }
+    memcpy(s->names + s->names_len, name, len);
+    s->names[s->names_len + len] = 0;
+    s->list[s->len].key = key;
+    s->list[s->len].name = s->names_len;
+    s->names_len += len + 1;
+    s->table[i] = ++s->len;
+
+    if(s->len * 2 > (1 << s->bits)) syms_grow(s);
+}
+
+int sym_hex(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/** Parses "BB:AAAA name" line, comments start with ';'. Returns 1 if symbol was added. */
+int syms_parse(syms* s, const char* line) {
+    const char* p = line;
+    int bank = 0, addr = 0, d, n;
+
+    while(*p == ' ' || *p == '\t') p++;
+    for(n=0; (d = sym_hex(*p)) >= 0; p++, n++) bank = (bank << 4) | d;
+    if(n == 0 || n > 4 || *p++ != ':') return 0;
+    for(n=0; (d = sym_hex(*p)) >= 0; p++, n++) addr = (addr << 4) | d;
+    if(n == 0 || n > 4 || (*p != ' ' && *p != '\t')) return 0;
+    while(*p == ' ' || *p == '\t') p++;
+    for(n=0; p[n] && p[n] != ' ' && p[n] != '\t' && p[n] != ';' && p[n] != '\r' && p[n] != '\n'; n++);
+    if(n == 0) return 0;
+    syms_add(s, bank, (uint16_t)addr, p, n);
+    return 1;
+}
+
+/** Loads symbols file line by line, returns number of symbols or -1. */
+int syms_load(syms* s, const char* filename) {
+    FILE*   f;
+    char    line[512];
+    int     n = 0, cont = 0;
+
+    f = fopen(filename, "r");
+    if(!f) return -1;
+    while(fgets(line, sizeof(line), f)) {
+        int full = strchr(line, '\n') != NULL;
+        /* rest of too long line is skipped */
+        if(!cont) n += syms_parse(s, line);
+        cont = !full;
+    }
+    fclose(f);
+    return n;
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef __GB_DASM_TRACE_H__
+#define __GB_DASM_TRACE_H__
+
+/* trace.h: Emulator execution traces, executed addresses as bitmap over ROM.
+
+   Text trace: lines starting with BB:AAAA (bank:pc), rest of line is ignored.
+   Binary trace: "GBTR" followed by little-endian uint16 bank, uint16 pc records. */
+
+#include "stdinc.h"
+#include "mem.h"
+#include "sym.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/** Bytes mapped at once. */
+#define TRACE_CHUNK     (64 << 20)
+/** Longest text line kept across chunks. */
+#define TRACE_LINE      256
+
+typedef struct trace {
+    /** Executed instructions, bit per ROM offset. */
+    uint64_t*   exec;
+    uint32_t    total;
+    /** Records parsed and records outside ROM. */
+    uint64_t    records;
+    uint64_t    outside;
+    /** Binary format. */
+    int         binary;
+    /** Partial text line from previous chunk. */
+    char        carry[TRACE_LINE];
+    int         carry_len;
+} trace;
+
+void trace_init(trace* t, uint32_t total) {
+    memset(t, 0, sizeof(trace));
+    t->total = total;
+    t->exec = (uint64_t*)mem_calloc(MEM_TRACE, (total >> 6) + 1, sizeof(uint64_t));
+}
+
+void trace_free(trace* t) {
+    if(t->exec) mem_free(t->exec);
+}
+
+int trace_executed(const trace* t, uint32_t off) {
+    return (t->exec[off >> 6] >> (off & 63)) & 1;
+}
+
+void trace_mark(trace* t, uint32_t bank, uint32_t addr) {
+    uint32_t off;
+
+    t->records++;
+    if(addr >= 0x8000) {
+        t->outside++;
+        return;
+    }
+    if(addr < 0x4000) off = addr;
+    else off = (bank ? bank : 1) * 0x4000 + addr - 0x4000;
+    if(off >= t->total) {
+        t->outside++;
+        return;
+    }
+    t->exec[off >> 6] |= 1ULL << (off & 63);
+}
+
+/** Text line, returns without marking when it doesn't start with BB:AAAA. */
+void trace_line(trace* t, const char* p, const char* end) {
+    uint32_t bank = 0, addr = 0;
+    int n, d;
+
+    while(p < end && (*p == ' ' || *p == '\t')) p++;
+    for(n=0; p < end && (d = sym_hex(*p)) >= 0; p++, n++) bank = (bank << 4) | d;
+    if(n == 0 || n > 4 || p >= end || *p++ != ':') return;
+    for(n=0; p < end && (d = sym_hex(*p)) >= 0; p++, n++) addr = (addr << 4) | d;
+    if(n == 0 || n > 4) return;
+    trace_mark(t, bank, addr);
+}
+
+/** Parses chunk, text lines crossing chunks are carried over. */
+void trace_chunk(trace* t, const uint8_t* data, uint32_t len) {
+    const char* p = (const char*)data;
+    const char* end = p + len;
+    const char* nl;
+
+    if(t->binary) {
+        uint32_t i;
+        for(i=0; i+4 <= len; i+=4)
+            trace_mark(t, data[i] | (data[i+1]<<8), data[i+2] | (data[i+3]<<8));
+        return;
+    }
+
+    if(t->carry_len) {
+        nl = (const char*)memchr(p, '\n', len);
+        if(!nl) nl = end;
+        if(t->carry_len + (nl - p) <= TRACE_LINE) {
+            memcpy(t->carry + t->carry_len, p, nl - p);
+            t->carry_len += nl - p;
+        }
+        if(nl == end) return;
+        trace_line(t, t->carry, t->carry + t->carry_len);
+        t->carry_len = 0;
+        p = nl + 1;
+    }
+    while(p < end) {
+        nl = (const char*)memchr(p, '\n', end - p);
+        if(!nl) {
+            /* partial line, longer ones can't start with a record anyway */
+            t->carry_len = end - p < TRACE_LINE ? end - p : TRACE_LINE;
+            memcpy(t->carry, p, t->carry_len);
+            return;
+        }
+        trace_line(t, p, nl);
+        p = nl + 1;
+    }
+}
+
+/** Streams trace file in chunks, returns 0 on success. */
+int trace_load(trace* t, const char* filename) {
+#ifndef _WIN32
+    struct stat st;
+    uint64_t    off;
+    int         fd;
+
+    fd = open(filename, O_RDONLY);
+    if(fd < 0) return -1;
+    if(fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    for(off = 0; off < (uint64_t)st.st_size; off += TRACE_CHUNK) {
+        uint64_t len = st.st_size - off < TRACE_CHUNK ? st.st_size - off : TRACE_CHUNK;
+        uint8_t* data = (uint8_t*)mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, off);
+        if(data == (uint8_t*)MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        madvise(data, len, MADV_SEQUENTIAL);
+        if(off == 0 && len >= 4 && memcmp(data, "GBTR", 4) == 0) {
+            t->binary = 1;
+            trace_chunk(t, data + 4, len - 4);
+        } else
+            trace_chunk(t, data, len);
+        munmap(data, len);
+    }
+    close(fd);
+#else
+    FILE*       f;
+    uint8_t*    data;
+    size_t      len;
+    int         first = 1;
+
+    f = fopen(filename, "rb");
+    if(!f) return -1;
+    data = (uint8_t*)mem_alloc(MEM_TRACE, 1 << 20);
+    while((len = fread(data, 1, 1 << 20, f)) > 0) {
+        if(first && len >= 4 && memcmp(data, "GBTR", 4) == 0) {
+            t->binary = 1;
+            trace_chunk(t, data + 4, len - 4);
+        } else
+            trace_chunk(t, data, len);
+        first = 0;
+    }
+    mem_free(data);
+    fclose(f);
+#endif
+    if(t->carry_len) trace_line(t, t->carry, t->carry + t->carry_len);
+    return 0;
+}
+
+/** Coverage per bank, static is bitmap of instructions decoded without trace. */
+void trace_report(const trace* t, const uint64_t* stat, FILE* f) {
+    uint32_t b, w, words;
+
+    words = (t->total + 63) >> 6;
+    fprintf(f, "Trace: %llu records, %llu outside ROM\n",
+        (unsigned long long)t->records, (unsigned long long)t->outside);
+    for(b=0; b*256 < words; b++) {
+        uint32_t s = 0, d = 0, both = 0;
+        for(w = b*256; w < (b+1)*256 && w < words; w++) {
+            s += popcount64(stat[w]);
+            d += popcount64(t->exec[w]);
+            both += popcount64(stat[w] & t->exec[w]);
+        }
+        fprintf(f, "Bank %.2X: static %u, dynamic %u, both %u, static only %u, dynamic only %u\n",
+            b, s, d, both, s - both, d - both);
+    }
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef __GB_DASM_XREF_H__
+#define __GB_DASM_XREF_H__
+
+/* xref.h: Cross references of data addresses (RAM, HRAM, I/O registers). */
+
+#include "sops.h"
+#include "io.h"
+
+/* Reference kinds. */
+#define XREF_READ   0
+#define XREF_WRITE  1
+/** Address loaded as immediate to 16-bit register, only 0x8000 and above. */
+#define XREF_PTR    2
+
+static const char XREF_KINDS[] = "RWP";
+
+/** Reference from instruction to data address. */
+typedef struct xref {
+    /** Instruction offset in ROM. */
+    uint32_t    off;
+    /** Referenced address. */
+    uint16_t    addr;
+    uint8_t     kind;
+    /** Instruction, set by xrefs_index. */
+    op*         o;
+} xref;
+
+/** References collected during decode. After xrefs_index references to
+    address a are refs[index[a]] .. refs[index[a+1]-1], sorted by offset. */
+typedef struct xrefs {
+    xref*       refs;
+    int         len;
+    int         reserved;
+    uint32_t*   index;
+} xrefs;
+
+void xrefs_init(xrefs* x) {
+    x->reserved = 1024;
+    x->refs = (xref*)mem_alloc(MEM_ANALYSIS, x->reserved * sizeof(xref));
+    x->len = 0;
+    x->index = NULL;
+}
+
+void xrefs_add(xrefs* x, uint16_t addr, uint32_t off, uint8_t kind) {
+    if(kind == XREF_PTR && addr < 0x8000) return;
+    if(x->len == x->reserved) {
+        x->reserved <<= 1;
+        x->refs = (xref*)mem_realloc(MEM_ANALYSIS, x->refs, x->reserved * sizeof(xref));
+    }
+    x->refs[x->len].off = off;
+    x->refs[x->len].addr = addr;
+    x->refs[x->len].kind = kind;
+    x->refs[x->len].o = NULL;
+    x->len++;
+}
+
+/** Builds index, linear in number of references and operations. */
+void xrefs_index(xrefs* x, op* head) {
+    xref*       tmp;
+    uint32_t*   count;
+    int         i, n, shift;
+
+    tmp = (xref*)mem_alloc(MEM_ANALYSIS, (x->len + 1) * sizeof(xref));
+    count = (uint32_t*)mem_alloc(MEM_ANALYSIS, 0x10001 * sizeof(uint32_t));
+
+    /* radix sort by offset, 16 bits per pass */
+    for(shift=0; shift<32; shift+=16) {
+        xref* sw;
+        memset(count, 0, 0x10001 * sizeof(uint32_t));
+        for(i=0; i<x->len; i++) count[((x->refs[i].off >> shift) & 0xFFFF) + 1]++;
+        for(i=0; i<0x10000; i++) count[i+1] += count[i];
+        for(i=0; i<x->len; i++) tmp[count[(x->refs[i].off >> shift) & 0xFFFF]++] = x->refs[i];
+        sw = x->refs; x->refs = tmp; tmp = sw;
+    }
+
+    /* instructions decoded twice are referenced once, and operations are merged in */
+    for(i=0, n=0; i<x->len; i++) {
+        if(n && x->refs[n-1].off == x->refs[i].off) continue;
+        while(head && head->off < x->refs[i].off) head = head->next;
+        x->refs[n] = x->refs[i];
+        x->refs[n++].o = (head && head->off == x->refs[i].off) ? head : NULL;
+    }
+    x->len = n;
+
+    /* stable counting sort by address */
+    x->index = count;
+    memset(count, 0, 0x10001 * sizeof(uint32_t));
+    for(i=0; i<x->len; i++) count[x->refs[i].addr + 1]++;
+    for(i=0; i<0x10000; i++) count[i+1] += count[i];
+    for(i=0; i<x->len; i++) tmp[count[x->refs[i].addr]++] = x->refs[i];
+    for(i=0x10000; i>0; i--) count[i] = count[i-1];
+    count[0] = 0;
+
+    mem_free(x->refs);
+    x->refs = tmp;
+    x->reserved = x->len + 1;
+}
+
+void xrefs_free(xrefs* x) {
+    if(x->refs) mem_free(x->refs);
+    if(x->index) mem_free(x->index);
+}
+
+/** Prints one reference. */
+void xref_print(const xref* ref, FILE* f) {
+    fprintf(f, "$%.4X %c [0x%.8X] %s\n", ref->addr, XREF_KINDS[ref->kind], ref->off,
+        ref->o ? ref->o->name : "?");
+}
+
+/** References to single address. */
+void xrefs_query(const xrefs* x, uint16_t addr, FILE* f) {
+    uint32_t i;
+
+    if(addr >= 0xFF00)
+        fprintf(f, "; $%.4X %s\n", addr, io_name(addr & 0xFF));
+    for(i = x->index[addr]; i < x->index[addr + 1]; i++)
+        xref_print(&x->refs[i], f);
+}
+
+/** All references, by address. */
+void xrefs_dump(const xrefs* x, FILE* f) {
+    int i;
+
+    for(i=0; i<x->len; i++)
+        xref_print(&x->refs[i], f);
+}
+
+#endif
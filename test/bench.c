@@ -0,0 +1,190 @@
+/* bench.c: End-to-end throughput on synthetic ROMs.
+
+   Every size is generated from the seed, written to disk and disassembled
+   repeatedly. Load, traversal, labelling and assembly emission are timed
+   separately, percentiles are over the runs after warmup. */
+
+#define GB_DISASM_NO_MAIN
+#include "../src/main.c"
+#include "synrom.h"
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_PHASES    5
+#define BENCH_MAX_SIZES 16
+
+static const char* BENCH_PHASE_NAMES[BENCH_PHASES] = {
+    "load", "traverse", "label", "emit", "total"
+};
+
+double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int bench_cmp(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : (x > y);
+}
+
+/** Nearest rank percentile of sorted samples. */
+double bench_pct(const double* sorted, int n, int pct) {
+    int i = (pct * n + 99) / 100 - 1;
+    return sorted[i < 0 ? 0 : i];
+}
+
+/** One disassembly, phase times in seconds. Decoded instructions and bytes are counted after. */
+int bench_run(const char* filename, FILE* out, double* t, uint32_t* insns, uint32_t* bytes) {
+    double  t0, t1, t2, t3, t4;
+    op*     o;
+
+    bank = 1;
+    start = 0x100;
+    end = 0x8000;
+    call_follow = 1;
+    jmp_follow = 1;
+
+    t0 = bench_now();
+    r = rom_load(filename);
+    if(!r) return -1;
+    t1 = bench_now();
+    disasm_init();
+    disasm_run();
+    t2 = bench_now();
+    disasm_label();
+    t3 = bench_now();
+    sops_asm(sops, out, r, &symbols);
+    fflush(out);
+    t4 = bench_now();
+
+    t[0] = t1 - t0;
+    t[1] = t2 - t1;
+    t[2] = t3 - t2;
+    t[3] = t4 - t3;
+    t[4] = t4 - t0;
+    *insns = *bytes = 0;
+    for(o = sops; o; o = o->next) {
+        if(!(o->flags & OP_FLAG_IS_DATA)) (*insns)++;
+        *bytes += o->len;
+    }
+
+    disasm_free();
+    rom_free(r);
+    return 0;
+}
+
+void bench_usage(const char* argv0) {
+    printf(
+        "Usage: %s [--sizes <KB,...>] [--seed <DEC>] [--runs <DEC>] [--warmup <DEC>] [--dir <DIR>]\n"
+        "       %s --gen <FILE> <KB> [--seed <DEC>]\n"
+        "  --sizes  -> ROM sizes in KB, powers of two 32-8192, default is 32,256,1024,8192\n"
+        "  --seed   -> generator seed, default is 1\n"
+        "  --runs   -> timed runs per size, default is 5\n"
+        "  --warmup -> untimed runs per size, default is 1\n"
+        "  --dir    -> directory for generated ROMs, default is /tmp\n"
+        "  --gen    -> only write synthetic ROM of given size\n",
+        argv0, argv0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t    sizes[BENCH_MAX_SIZES] = { 32, 256, 1024, 8192 };
+    int         nsizes = 4;
+    uint32_t    seed = 1;
+    int         runs = 5, warmup = 1;
+    const char* dir = "/tmp";
+    const char* gen_file = NULL;
+    char        filename[1024];
+    double*     samples[BENCH_PHASES];
+    FILE*       null_out;
+    int         arg, s, i, p, null_fd, saved_fd;
+
+    for(arg=1; arg<argc; arg++) {
+        if(strcmp(argv[arg], "--sizes") == 0 && arg+1 < argc) {
+            char* tok = strtok(argv[++arg], ",");
+            for(nsizes = 0; tok && nsizes < BENCH_MAX_SIZES; tok = strtok(NULL, ","))
+                sizes[nsizes++] = atoi(tok);
+        } else if(strcmp(argv[arg], "--seed") == 0 && arg+1 < argc)
+            seed = strtoul(argv[++arg], NULL, 10);
+        else if(strcmp(argv[arg], "--runs") == 0 && arg+1 < argc)
+            runs = atoi(argv[++arg]);
+        else if(strcmp(argv[arg], "--warmup") == 0 && arg+1 < argc)
+            warmup = atoi(argv[++arg]);
+        else if(strcmp(argv[arg], "--dir") == 0 && arg+1 < argc)
+            dir = argv[++arg];
+        else if(strcmp(argv[arg], "--gen") == 0 && arg+2 < argc) {
+            gen_file = argv[++arg];
+            sizes[0] = atoi(argv[++arg]);
+            nsizes = 1;
+        } else {
+            bench_usage(argv[0]);
+            return -1;
+        }
+    }
+    if(runs < 1) runs = 1;
+
+    if(gen_file) {
+        if(synrom_write(gen_file, sizes[0] << 10, seed) < 0) {
+            printf("Could not write %u KB ROM to %s\n", sizes[0], gen_file);
+            return -2;
+        }
+        return 0;
+    }
+
+    /* traversal warnings and emitted assembly go to /dev/null */
+    null_out = fopen("/dev/null", "w");
+    null_fd = open("/dev/null", O_WRONLY);
+    if(!null_out || null_fd < 0) {
+        puts("Could not open /dev/null");
+        return -3;
+    }
+    for(p=0; p<BENCH_PHASES; p++)
+        samples[p] = (double*)malloc(runs * sizeof(double));
+
+    for(s=0; s<nsizes; s++) {
+        uint32_t insns = 0, bytes = 0;
+        double   t[BENCH_PHASES], total;
+
+        sprintf(filename, "%s/synrom_%uk_%u.gb", dir, sizes[s], seed);
+        if(synrom_write(filename, sizes[s] << 10, seed) < 0) {
+            printf("Could not write %u KB ROM to %s\n", sizes[s], filename);
+            return -2;
+        }
+
+        fflush(stdout);
+        saved_fd = dup(1);
+        dup2(null_fd, 1);
+        for(i=0; i<warmup + runs; i++) {
+            if(bench_run(filename, null_out, t, &insns, &bytes) < 0) break;
+            if(i >= warmup)
+                for(p=0; p<BENCH_PHASES; p++) samples[p][i - warmup] = t[p];
+        }
+        fflush(stdout);
+        dup2(saved_fd, 1);
+        close(saved_fd);
+        if(i < warmup + runs) {
+            printf("Could not load ROM file %s\n", filename);
+            return -2;
+        }
+
+        printf("%s: %u KB, %u instructions, %u bytes decoded (%.1f%%), %d runs\n",
+            filename, sizes[s], insns, bytes, 100.0 * bytes / (sizes[s] << 10), runs);
+        printf("  %-10s %10s %10s %10s %10s\n", "phase", "min ms", "p50 ms", "p90 ms", "p99 ms");
+        for(p=0; p<BENCH_PHASES; p++) {
+            qsort(samples[p], runs, sizeof(double), bench_cmp);
+            printf("  %-10s %10.3f %10.3f %10.3f %10.3f\n", BENCH_PHASE_NAMES[p],
+                samples[p][0] * 1e3, bench_pct(samples[p], runs, 50) * 1e3,
+                bench_pct(samples[p], runs, 90) * 1e3, bench_pct(samples[p], runs, 99) * 1e3);
+        }
+        total = bench_pct(samples[BENCH_PHASES-1], runs, 50);
+        printf("  %.2f M instructions/s, %.2f MB/s (p50 total)\n\n",
+            insns / total * 1e-6, (sizes[s] / 1024.0) / total);
+    }
+
+    for(p=0; p<BENCH_PHASES; p++) free(samples[p]);
+    fclose(null_out);
+    close(null_fd);
+    return 0;
+}
@@ -0,0 +1,222 @@
+/* microbench.c: Hot primitives in isolation, ns per operation as CSV.
+
+   Every benchmark runs warmup iterations first, then fixed number of timed
+   iterations. Inputs come from synthetic ROM generated in memory. */
+
+#define GB_DISASM_NO_MAIN
+#include "../src/main.c"
+#include "synrom.h"
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MICRO_ROM_SIZE  (256 << 10)
+#define MICRO_SAMPLES   4096
+
+/** Results are accumulated here, so calls are not optimized out. */
+volatile uint32_t micro_sink;
+
+/** Offsets and logical addresses of instructions without control flow. */
+uint32_t    micro_off[MICRO_SAMPLES];
+uint16_t    micro_pc[MICRO_SAMPLES];
+int         micro_bank[MICRO_SAMPLES];
+int         micro_len;
+
+double micro_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef void (*micro_fn)(uint32_t i);
+
+void micro_phy(uint32_t i) {
+    bank = micro_bank[i % micro_len];
+    micro_sink += phy(micro_pc[i % micro_len]);
+}
+
+/** One decode dispatch with its op_create and operations lookup, samples are on the list after
+    the first pass, so sops_add frees the op. References are restarted every pass, their array
+    doesn't grow with iterations. */
+void micro_decode(uint32_t i) {
+    if(i % micro_len == 0) data_refs.len = 0;
+    bank = micro_bank[i % micro_len];
+    pc = micro_pc[i % micro_len];
+    disasm_step();
+    micro_sink += pc;
+}
+
+/** Insertion in address order, list is restarted every MICRO_SAMPLES operations. */
+void micro_sops_add(uint32_t i) {
+    if(i % micro_len == 0) {
+        sops_free(sops);
+        sops_idx_free(&ops_index);
+        sops = NULL;
+        sops_idx_init(&ops_index, r->total);
+    }
+    sops = sops_add(sops, &ops_index, op_create(micro_off[i % micro_len], r->raw, 1, "NOP"));
+}
+
+/** Insertion in reversed address order, predecessor lookup crosses the whole gap. */
+void micro_sops_add_rev(uint32_t i) {
+    if(i % micro_len == 0) {
+        sops_free(sops);
+        sops_idx_free(&ops_index);
+        sops = NULL;
+        sops_idx_init(&ops_index, r->total);
+    }
+    sops = sops_add(sops, &ops_index, op_create(micro_off[micro_len - 1 - i % micro_len], r->raw, 1, "NOP"));
+}
+
+void micro_sops_contains(uint32_t i) {
+    micro_sink += sops_contains(&ops_index, micro_off[i % micro_len] + (i & 1));
+}
+
+void micro_sops_overlap(uint32_t i) {
+    micro_sink += sops_overlap(&ops_index, micro_off[i % micro_len] + (i & 1), 3);
+}
+
+void micro_op_r16(uint32_t i) {
+    op* o;
+    bank = micro_bank[i % micro_len];
+    pc = micro_pc[i % micro_len];
+    o = op_r16("LD BC,", (uint16_t)(i * 2654435761U));
+    micro_sink += o->name[7];
+    mem_free(o);
+}
+
+void micro_op_l8(uint32_t i) {
+    op* o;
+    bank = micro_bank[i % micro_len];
+    pc = micro_pc[i % micro_len];
+    o = op_l8("LDH ", (uint8_t)i, ",A");
+    micro_sink += o->name[5];
+    mem_free(o);
+}
+
+void micro_io_name(uint32_t i) {
+    micro_sink += io_name((uint8_t)i)[0];
+}
+
+FILE*   micro_out;
+op*     micro_ops;
+int     micro_ops_len;
+
+/** Lines for decoded operations, labels included. */
+void micro_asm_op(uint32_t i) {
+    sops_asm_op(micro_out, &micro_ops[i % micro_ops_len], &symbols);
+}
+
+/** Data lines of 256 bytes, dispatched kernel and scalar one. */
+#define MICRO_HEX_BYTES 256
+char    micro_hex[HEX_DB_SIZE(MICRO_HEX_BYTES)];
+
+void micro_hex_db(uint32_t i) {
+    micro_sink += hex_db(micro_hex, r->raw + (i * MICRO_HEX_BYTES) % MICRO_ROM_SIZE, MICRO_HEX_BYTES);
+}
+
+void micro_hex_db_scalar(uint32_t i) {
+    micro_sink += hex_db_scalar(micro_hex, r->raw + (i * MICRO_HEX_BYTES) % MICRO_ROM_SIZE, MICRO_HEX_BYTES);
+}
+
+/** Fill check of aligned 16-byte block, cost of --fill scan per block. */
+void micro_fill_uniform(uint32_t i) {
+    micro_sink += fill_uniform(r->raw + (i * 16) % MICRO_ROM_SIZE);
+}
+
+/** Warmup plus timed iterations, prints CSV row. */
+void micro_run(const char* name, micro_fn fn, uint32_t iterations) {
+    double      t0, t1;
+    uint32_t    i;
+
+    for(i=0; i<iterations / 10; i++) fn(i);
+    t0 = micro_now();
+    for(i=0; i<iterations; i++) fn(i);
+    t1 = micro_now();
+    printf("%s,%u,%.3f,%.2f\n", name, iterations, (t1 - t0) * 1e3, (t1 - t0) * 1e9 / iterations);
+}
+
+int main(int argc, char** argv) {
+    uint32_t    iterations = 1000000;
+    uint32_t    seed = 1;
+    uint32_t    off;
+    uint8_t*    raw;
+    op*         o;
+    int         arg, n, saved_fd;
+
+    for(arg=1; arg<argc; arg++) {
+        if(strcmp(argv[arg], "--iterations") == 0 && arg+1 < argc)
+            iterations = strtoul(argv[++arg], NULL, 10);
+        else if(strcmp(argv[arg], "--seed") == 0 && arg+1 < argc)
+            seed = strtoul(argv[++arg], NULL, 10);
+        else {
+            printf("Usage: %s [--iterations <DEC>] [--seed <DEC>]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    /* ROM is freed by rom_free */
+    raw = synrom_create(MICRO_ROM_SIZE, seed);
+    r = (rom*)mem_alloc(MEM_ROM, sizeof(rom));
+    r->raw = (uint8_t*)mem_alloc(MEM_ROM, MICRO_ROM_SIZE);
+    memcpy(r->raw, raw, MICRO_ROM_SIZE);
+    free(raw);
+    r->total = MICRO_ROM_SIZE;
+    r->filename = mem_strdup(MEM_ROM, "synrom.gb");
+    bank = 1;
+    start = 0x100;
+    end = 0x8000;
+    call_follow = 1;
+    jmp_follow = 1;
+
+    /* full disassembly, its operations are the samples, traversal messages are dropped */
+    fflush(stdout);
+    saved_fd = dup(1);
+    dup2(open("/dev/null", O_WRONLY), 1);
+    disasm_init();
+    disasm_run();
+    disasm_label();
+    fflush(stdout);
+    dup2(saved_fd, 1);
+    close(saved_fd);
+    for(o = sops, n = 0; o; o = o->next) n++;
+    micro_ops = (op*)malloc(MICRO_SAMPLES * sizeof(op));
+    for(o = sops, micro_len = micro_ops_len = 0, off = 0; o && micro_ops_len < MICRO_SAMPLES; o = o->next, off++) {
+        if(off % (n / MICRO_SAMPLES + 1)) continue;
+        micro_ops[micro_ops_len++] = *o;
+        if(OPDESC_FLOW[o->code[0]] == OPDESC_FLOW_NONE && !(o->flags & OP_FLAG_IS_DATA) &&
+                o->code[0] != 0xEA && o->code[0] != 0x76) {
+            micro_off[micro_len] = o->off;
+            micro_pc[micro_len] = o->off < 0x4000 ? o->off : 0x4000 + (o->off % 0x4000);
+            micro_bank[micro_len] = o->off < 0x4000 ? 1 : o->off / 0x4000;
+            micro_len++;
+        }
+    }
+    micro_out = fopen("/dev/null", "w");
+    if(!micro_out || !micro_len) {
+        puts("Could not prepare benchmark");
+        return -2;
+    }
+
+    printf("benchmark,iterations,total_ms,ns_per_op\n");
+    micro_run("phy", micro_phy, iterations);
+    micro_run("decode", micro_decode, iterations);
+    micro_run("sops_contains", micro_sops_contains, iterations);
+    micro_run("sops_overlap", micro_sops_overlap, iterations);
+    micro_run("op_r16", micro_op_r16, iterations);
+    micro_run("op_l8", micro_op_l8, iterations);
+    micro_run("io_name", micro_io_name, iterations);
+    micro_run("sops_asm_op", micro_asm_op, iterations);
+    micro_run("hex_db", micro_hex_db, iterations);
+    micro_run("hex_db_scalar", micro_hex_db_scalar, iterations);
+    micro_run("fill_uniform", micro_fill_uniform, iterations);
+    micro_run("sops_add", micro_sops_add, iterations);
+    micro_run("sops_add_rev", micro_sops_add_rev, iterations);
+
+    fclose(micro_out);
+    free(micro_ops);
+    disasm_free();
+    rom_free(r);
+    return 0;
+}
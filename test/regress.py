@@ -0,0 +1,222 @@
+#!/usr/bin/env python
+
+# Golden output regression tests with wall time and peak memory budgets.
+#
+# Cases are listed in regress.txt, fixture ROMs are generated by gb-bench --gen
+# (same size and seed give the same ROM) or read from roms/. Output must match golden/<case>.out
+# byte for byte, or golden/<case>.sha1 for outputs too big to keep in the tree.
+# Argument ending with / is output directory, its files are appended to stdout
+# in name order, and bank files written by --split-banks must cover the whole ROM.
+# Other arguments naming a file in roms/ are copied with the ROM.
+# Median wall time of the runs and peak RSS are compared to golden/budgets.txt,
+# case fails when it is more than tolerance percent over its budget. Wall time
+# budget is relative to calibration run in the same session, median time of
+# gb-bench generating 4 MB ROM, so budgets hold on slower and busier machines.
+# Wall time budget - checks output and RSS only, for cases whose time depends on
+# CPUs count. RSS budgets are absolute KB.
+#
+# Usage: regress.py [--disasm <FILE>] [--bench <FILE>] [--runs <N>] [--tolerance <PCT>] [--update]
+
+import hashlib
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+GOLDEN = os.path.join(HERE, 'golden')
+BUDGETS = os.path.join(GOLDEN, 'budgets.txt')
+# bigger outputs are kept as hash only
+MAX_GOLDEN = 256 << 10
+# timer noise on short cases
+SLACK_MS = 5.0
+# calibration ROM size in KB, its generation doesn't run disassembler code
+CALIBRATE_KB = 4096
+
+
+def read_cases():
+    cases = []
+    for line in open(os.path.join(HERE, 'regress.txt')):
+        line = line.split('#')[0].split()
+        if line:
+            # fixture ROM file instead of size, seed is -
+            if line[1].isdigit():
+                cases.append((line[0], int(line[1]), int(line[2]), line[3:]))
+            else:
+                cases.append((line[0], line[1], None, line[3:]))
+    return cases
+
+
+def read_budgets():
+    budgets = {}
+    if os.path.exists(BUDGETS):
+        for line in open(BUDGETS):
+            line = line.split('#')[0].split()
+            if line:
+                budgets[line[0]] = (None if line[1] == '-' else float(line[1]), int(line[2]))
+    return budgets
+
+
+def run(cmd, cwd, out):
+    """Runs command with stdout to file, returns wall ms and peak RSS in KB."""
+    f = open(out, 'wb')
+    t0 = time.time()
+    p = subprocess.Popen(cmd, cwd=cwd, stdout=f)
+    pid, status, usage = os.wait4(p.pid, 0)
+    wall = (time.time() - t0) * 1000.0
+    f.close()
+    p.returncode = os.WEXITSTATUS(status)
+    if p.returncode != 0:
+        raise RuntimeError('%s exited with %d' % (' '.join(cmd), p.returncode))
+    return wall, usage.ru_maxrss
+
+
+def read_dir(tmp, d):
+    """Files in output directory in name order, each after its name line."""
+    data = b''
+    for name in sorted(os.listdir(os.path.join(tmp, d))):
+        data += ('== %s ==\n' % name).encode() + open(os.path.join(tmp, d, name), 'rb').read()
+    # INCBIN lines have absolute ROM path
+    return data.replace((os.path.realpath(tmp) + '/').encode(), b'')
+
+
+def check_banks(tmp, d, rom):
+    """Errors if bank files and Makefile objects are not every bank of ROM."""
+    names = ['bank%02X' % i for i in range((os.path.getsize(os.path.join(tmp, rom)) + 0x3FFF) // 0x4000)]
+    files = sorted(f[:-4] for f in os.listdir(os.path.join(tmp, d)) if f.endswith('.asm'))
+    errors = []
+    if files != names:
+        errors.append('bank files %s are not banks 00-%s' % (' '.join(files), names[-1][4:]))
+    for line in open(os.path.join(tmp, d, 'Makefile')):
+        if line.startswith('OBJS =') and line.split()[2:] != [n + '.o' for n in names]:
+            errors.append('Makefile doesn\'t link every bank')
+    return errors
+
+
+def median(values):
+    values = sorted(values)
+    n = len(values)
+    return values[n // 2] if n % 2 else (values[n // 2 - 1] + values[n // 2]) / 2.0
+
+
+def calibrate(bench, tmp, runs):
+    """Median wall ms of generating calibration ROM."""
+    walls = []
+    for i in range(max(runs, 3)):
+        walls.append(run([bench, '--gen', 'calibrate.gb', str(CALIBRATE_KB), '--seed', '1'],
+            tmp, os.devnull)[0])
+    os.remove(os.path.join(tmp, 'calibrate.gb'))
+    return median(walls)
+
+
+def main():
+    args = sys.argv[1:]
+    disasm = os.path.join(HERE, '..', 'bin', 'gb-disasm')
+    bench = os.path.join(HERE, '..', 'bin', 'gb-bench')
+    runs, tolerance, update = 5, 40.0, False
+    while args:
+        a = args.pop(0)
+        if a == '--disasm': disasm = args.pop(0)
+        elif a == '--bench': bench = args.pop(0)
+        elif a == '--runs': runs = int(args.pop(0))
+        elif a == '--tolerance': tolerance = float(args.pop(0))
+        elif a == '--update': update = True
+        else:
+            print('Usage: regress.py [--disasm <FILE>] [--bench <FILE>] [--runs <N>] [--tolerance <PCT>] [--update]')
+            return 2
+    disasm = os.path.abspath(disasm)
+    bench = os.path.abspath(bench)
+
+    budgets = read_budgets()
+    tmp = tempfile.mkdtemp(prefix='gb-regress-')
+    failed = 0
+    try:
+        calib = calibrate(bench, tmp, runs)
+        print('calibration %.1f ms' % calib)
+        for name, kb, seed, opts in read_cases():
+            if seed is None:
+                rom = kb
+                # copied, INCBIN lines have the path as given
+                shutil.copyfile(os.path.join(HERE, 'roms', rom), os.path.join(tmp, rom))
+            else:
+                rom = 'synrom_%dk_%d.gb' % (kb, seed)
+            for a in opts:
+                if os.path.isfile(os.path.join(HERE, 'roms', a)):
+                    shutil.copyfile(os.path.join(HERE, 'roms', a), os.path.join(tmp, a))
+            dirs = [a for a in opts if a.endswith('/')]
+            if not os.path.exists(os.path.join(tmp, rom)):
+                subprocess.check_call([bench, '--gen', rom, str(kb), '--seed', str(seed)], cwd=tmp)
+            out = os.path.join(tmp, name + '.out')
+            walls, rss = [], 0
+            for i in range(max(runs, 1)):
+                for d in dirs:
+                    shutil.rmtree(os.path.join(tmp, d), ignore_errors=True)
+                w, m = run([disasm, rom] + opts, tmp, out)
+                walls.append(w)
+                rss = max(rss, m)
+            wall = median(walls)
+            data = open(out, 'rb').read()
+            for d in dirs:
+                data += read_dir(tmp, d)
+            open(out, 'wb').write(data)
+            sha1 = hashlib.sha1(data).hexdigest()
+
+            golden_out = os.path.join(GOLDEN, name + '.out')
+            golden_sha1 = os.path.join(GOLDEN, name + '.sha1')
+            if update:
+                for g in (golden_out, golden_sha1):
+                    if os.path.exists(g): os.remove(g)
+                if len(data) <= MAX_GOLDEN:
+                    shutil.copyfile(out, golden_out)
+                else:
+                    open(golden_sha1, 'w').write(sha1 + '\n')
+                budgets[name] = (None if name in budgets and budgets[name][0] is None else wall / calib, rss)
+                print('updated %s: %d bytes, %.1f ms, %d KB' % (name, len(data), wall, rss))
+                continue
+
+            errors = []
+            for d in dirs:
+                if os.path.exists(os.path.join(tmp, d, 'Makefile')):
+                    errors += check_banks(tmp, d, rom)
+            failed_out = os.path.join(HERE, name + '.failed.out')
+            if os.path.exists(golden_out):
+                if open(golden_out, 'rb').read() != data:
+                    errors.append('output differs from %s, see %s' % (golden_out, failed_out))
+            elif os.path.exists(golden_sha1):
+                if open(golden_sha1).read().strip() != sha1:
+                    errors.append('output hash %s differs from %s, see %s' % (sha1, golden_sha1, failed_out))
+            else:
+                errors.append('no golden output')
+            if name in budgets:
+                bwall, brss = budgets[name]
+                if bwall is not None and wall > bwall * calib * (1 + tolerance / 100.0) + SLACK_MS:
+                    errors.append('wall time %.1f ms over budget %.1f ms' % (wall, bwall * calib))
+                if rss > brss * (1 + tolerance / 100.0):
+                    errors.append('peak RSS %d KB over budget %d KB' % (rss, brss))
+            else:
+                errors.append('no budget')
+
+            print('%-6s %-14s %8.1f ms %8d KB' % ('FAIL' if errors else 'ok', name, wall, rss))
+            for e in errors:
+                print('       ' + e)
+            if errors:
+                failed += 1
+                shutil.copyfile(out, failed_out)
+    finally:
+        shutil.rmtree(tmp)
+
+    if update:
+        f = open(BUDGETS, 'w')
+        f.write('# case wall_time/calibration_time peak_rss_kb, written by regress.py --update\n')
+        for name in sorted(budgets):
+            wall = '-' if budgets[name][0] is None else '%.4f' % budgets[name][0]
+            f.write('%s %s %d\n' % (name, wall, budgets[name][1]))
+        f.close()
+        return 0
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
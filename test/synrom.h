@@ -0,0 +1,300 @@
+#ifndef __GB_DASM_SYNROM_H__
+#define __GB_DASM_SYNROM_H__
+
+/* synrom.h: Deterministic synthetic ROMs for benchmarks and regression tests.
+
+   MBC5 header, every bank is filled with functions calling each other and bank 0,
+   loops, forward branches, inline and RST $28 jump tables, data islands between
+   functions and $FF padding at the end. Same seed and size give the same ROM. */
+
+#include "../src/stdinc.h"
+#include "../src/opdesc.h"
+
+/** RST vector of jump table dispatcher. */
+#define SYN_RST_JTAB    0x28
+/** Space kept at end of bank, longest function with its tables fits in. */
+#define SYN_MARGIN      0x300
+#define SYN_MAX_INSNS   64
+#define SYN_MAX_FUNCS   2048
+
+typedef struct synrom {
+    uint8_t*    raw;
+    uint32_t    total;
+    uint32_t    seed;
+    /** Current bank, physical offset of its logical address 0, pc is logical. */
+    uint32_t    bank;
+    uint32_t    base;
+    uint16_t    pc;
+    /** Functions of current bank and of bank 0, callable from any bank. */
+    uint16_t    funcs[SYN_MAX_FUNCS];
+    int         funcs_len;
+    uint16_t    funcs0[SYN_MAX_FUNCS];
+    int         funcs0_len;
+    /** Opcodes without control flow, used for function bodies. */
+    uint8_t     plain[0x100];
+    int         plain_len;
+} synrom;
+
+/** xorshift32, never returns 0 state. */
+uint32_t syn_rand(synrom* s) {
+    s->seed ^= s->seed << 13;
+    s->seed ^= s->seed >> 17;
+    s->seed ^= s->seed << 5;
+    return s->seed;
+}
+
+uint32_t syn_range(synrom* s, uint32_t n) {
+    return syn_rand(s) % n;
+}
+
+void syn_byte(synrom* s, uint8_t b) {
+    s->raw[s->base + s->pc++] = b;
+}
+
+void syn_word(synrom* s, uint16_t w) {
+    syn_byte(s, w & 0xFF);
+    syn_byte(s, w >> 8);
+}
+
+/** Work RAM address, operands of memory loads and stores. */
+uint16_t syn_ram(synrom* s) {
+    return 0xC000 + syn_range(s, 0x2000);
+}
+
+/** Instruction without control flow. */
+void syn_plain(synrom* s) {
+    uint8_t code = s->plain[syn_range(s, s->plain_len)];
+
+    syn_byte(s, code);
+    switch(OPDESC_LEN[code]) {
+        case 2:
+            syn_byte(s, syn_rand(s) & 0xFF);
+            break;
+        case 3:
+            if(code == 0x08 || code == 0xEA || code == 0xFA)
+                syn_word(s, syn_ram(s));
+            else
+                syn_word(s, syn_rand(s) & 0xFFFF);
+            break;
+    }
+}
+
+/** Short handler reached through jump table. */
+void syn_handler(synrom* s) {
+    int i, n = 1 + syn_range(s, 5);
+
+    for(i=0; i<n; i++) syn_plain(s);
+    syn_byte(s, 0xC9); /* RET */
+}
+
+/** Table of n entries at pc followed by its handlers. */
+void syn_table(synrom* s, int n) {
+    uint16_t table = s->pc;
+    int i;
+
+    s->pc += n * 2;
+    for(i=0; i<n; i++) {
+        s->raw[s->base + table + i*2] = s->pc & 0xFF;
+        s->raw[s->base + table + i*2 + 1] = s->pc >> 8;
+        syn_handler(s);
+    }
+}
+
+/** Function calling previous function of the bank, so every function is reachable.
+    Calls go to earlier functions only. */
+void syn_func(synrom* s) {
+    uint16_t    insn[SYN_MAX_INSNS];
+    int         i, n, calls_prev, end;
+
+    n = 8 + syn_range(s, SYN_MAX_INSNS - 16);
+    calls_prev = s->funcs_len ? syn_range(s, n) : -1;
+    for(i=0; i<n; i++) {
+        uint32_t r = syn_range(s, 100);
+        insn[i] = s->pc;
+        if(i == calls_prev || (r < 5 && s->funcs_len)) {
+            /* CALL, sometimes conditional, to earlier function of the bank */
+            uint16_t dst = i == calls_prev ? s->funcs[s->funcs_len-1] :
+                s->funcs[syn_range(s, s->funcs_len)];
+            syn_byte(s, r < 2 ? 0xC4 : 0xCD);
+            syn_word(s, dst);
+        } else if(r < 8 && s->funcs0_len && s->bank) {
+            syn_byte(s, 0xCD); /* CALL to bank 0 */
+            syn_word(s, s->funcs0[syn_range(s, s->funcs0_len)]);
+        } else if(r < 12 && i > 2) {
+            /* loop back, JR NZ or JR C */
+            int t = i - 1 - syn_range(s, i < 8 ? i : 8);
+            if(s->pc + 2 - insn[t] > 128) t = i - 1;
+            syn_byte(s, r & 1 ? 0x38 : 0x20);
+            syn_byte(s, (uint8_t)(insn[t] - (s->pc + 1)));
+        } else if(r < 17) {
+            /* skip few instructions forward, JR Z or JR NC */
+            uint16_t at = s->pc;
+            int k, skip = 1 + syn_range(s, 4);
+            syn_byte(s, r & 1 ? 0x28 : 0x30);
+            syn_byte(s, 0);
+            for(k=0; k<skip; k++) syn_plain(s);
+            s->raw[s->base + at + 1] = (uint8_t)(s->pc - (at + 2));
+        } else if(r < 18) {
+            syn_byte(s, 0xC0); /* RET NZ */
+        } else
+            syn_plain(s);
+    }
+
+    end = syn_range(s, 100);
+    if(end < 4) {
+        /* inline jump table: LD HL,table; ADD A,A; LD E,A; LD D,0; ADD HL,DE; LD A,[HL+]; LD H,[HL]; LD L,A; JP [HL] */
+        static const uint8_t tail[] = { 0x87, 0x5F, 0x16, 0x00, 0x19, 0x2A, 0x66, 0x6F, 0xE9 };
+        syn_byte(s, 0x21);
+        syn_word(s, s->pc + 2 + sizeof(tail));
+        for(i=0; i<(int)sizeof(tail); i++) syn_byte(s, tail[i]);
+        syn_table(s, 2 + syn_range(s, 7));
+    } else if(end < 8) {
+        /* LD A,n; RST $28 followed by table */
+        syn_byte(s, 0x3E);
+        syn_byte(s, syn_rand(s) & 0x07);
+        syn_byte(s, 0xC7 | SYN_RST_JTAB);
+        syn_table(s, 2 + syn_range(s, 7));
+    } else if(end < 14 && s->funcs_len) {
+        syn_byte(s, 0xC3); /* tail jump */
+        syn_word(s, s->funcs[syn_range(s, s->funcs_len)]);
+    } else
+        syn_byte(s, 0xC9); /* RET */
+}
+
+/** Functions and data islands from pc until limit, returns last function. */
+uint16_t syn_bank(synrom* s, uint16_t limit) {
+    uint16_t entry;
+
+    s->funcs_len = 0;
+    while(s->pc + SYN_MARGIN < limit && s->funcs_len < SYN_MAX_FUNCS) {
+        if(syn_range(s, 100) < 10) {
+            /* data island, never executed */
+            int i, n = 16 + syn_range(s, 240);
+            for(i=0; i<n; i++) syn_byte(s, syn_rand(s) & 0xFF);
+        }
+        entry = s->pc;
+        syn_func(s);
+        s->funcs[s->funcs_len++] = entry;
+    }
+    return s->funcs[s->funcs_len-1];
+}
+
+/** MBC5 cartridge header with checksums. */
+void syn_header(synrom* s) {
+    uint8_t     x = 0;
+    uint16_t    sum = 0;
+    uint32_t    i, size;
+
+    memcpy(s->raw + 0x134, "SYNROM", 6);
+    s->raw[0x147] = 0x19; /* MBC5 */
+    for(size = 0; (0x8000U << size) < s->total; size++);
+    s->raw[0x148] = size;
+    s->raw[0x149] = 0x00;
+    s->raw[0x14A] = 0x01;
+    for(i=0x134; i<0x14D; i++) x = x - s->raw[i] - 1;
+    s->raw[0x14D] = x;
+    for(i=0; i<s->total; i++)
+        if(i != 0x14E && i != 0x14F) sum += s->raw[i];
+    s->raw[0x14E] = sum >> 8;
+    s->raw[0x14F] = sum & 0xFF;
+}
+
+/** Generates ROM of size bytes, power of two from 32 KB to 8 MB. Returns NULL for other sizes. */
+uint8_t* synrom_create(uint32_t size, uint32_t seed) {
+    /* POP HL; ADD A,A; LD E,A; LD D,0; ADD HL,DE; LD A,[HL+]; LD H,[HL]; LD L,A; JP [HL] */
+    static const uint8_t dispatcher[] = { 0xE1, 0x87, 0x5F, 0x16, 0x00, 0x19, 0x2A, 0x66, 0x6F, 0xE9 };
+    synrom*     s;
+    uint8_t*    raw;
+    uint16_t    main_call, entry, last;
+    uint32_t    b, banks;
+    int         i;
+
+    if(size < 0x8000 || size > 0x800000 || (size & (size - 1))) return NULL;
+    s = (synrom*)calloc(1, sizeof(synrom));
+    s->total = size;
+    s->seed = seed ? seed : 1;
+    s->raw = (uint8_t*)malloc(size);
+    memset(s->raw, 0xFF, size);
+    memset(s->raw, 0xC9, 0x100); /* unused vectors RET */
+    memset(s->raw + 0x104, 0x00, 0x4C);
+    banks = size / 0x4000;
+
+    for(i=0; i<0x100; i++) {
+        uint8_t f = OPDESC_FLOW[i];
+        if(OPDESC_LEN[i] && f == OPDESC_FLOW_NONE && i != 0x10 && i != 0x76)
+            s->plain[s->plain_len++] = i;
+    }
+
+    /* vectors, entry point and main calling every bank */
+    s->pc = SYN_RST_JTAB;
+    for(i=0; i<(int)sizeof(dispatcher); i++) syn_byte(s, dispatcher[i]);
+    s->pc = 0x100;
+    syn_byte(s, 0x00); /* NOP */
+    syn_byte(s, 0xC3); /* JP $0150 */
+    syn_word(s, 0x150);
+    s->pc = 0x150;
+    syn_byte(s, 0xF3); /* DI */
+    syn_byte(s, 0x31); /* LD SP,$FFFE */
+    syn_word(s, 0xFFFE);
+    main_call = s->pc;
+    s->pc += 3;
+    for(b=1; b<banks; b++) {
+        syn_byte(s, 0x3E); /* LD A,bank; LD [$2000],A; LD A,bank>>8; LD [$3000],A; CALL $4000 */
+        syn_byte(s, b & 0xFF);
+        syn_byte(s, 0xEA);
+        syn_word(s, 0x2000);
+        syn_byte(s, 0x3E);
+        syn_byte(s, b >> 8);
+        syn_byte(s, 0xEA);
+        syn_word(s, 0x3000);
+        syn_byte(s, 0xCD);
+        syn_word(s, 0x4000);
+    }
+    syn_byte(s, 0x18); /* JR @ */
+    syn_byte(s, 0xFE);
+
+    /* bank 0 functions, callable from every bank */
+    last = syn_bank(s, 0x4000);
+    memcpy(s->funcs0, s->funcs, s->funcs_len * sizeof(uint16_t));
+    s->funcs0_len = s->funcs_len;
+    s->pc = main_call;
+    syn_byte(s, 0xCD);
+    syn_word(s, last);
+
+    /* switchable banks start with jump to their last function */
+    for(b=1; b<banks; b++) {
+        s->bank = b;
+        s->base = (b - 1) * 0x4000;
+        s->pc = 0x4000;
+        entry = s->pc;
+        s->pc += 3;
+        last = syn_bank(s, 0x8000);
+        s->pc = entry;
+        syn_byte(s, 0xC3);
+        syn_word(s, last);
+    }
+
+    syn_header(s);
+    raw = s->raw;
+    free(s);
+    return raw;
+}
+
+/** Writes generated ROM to file, returns 0 on success. */
+int synrom_write(const char* filename, uint32_t size, uint32_t seed) {
+    uint8_t*    raw;
+    FILE*       f;
+    int         ok;
+
+    if(!(raw = synrom_create(size, seed))) return -1;
+    if(!(f = fopen(filename, "wb"))) {
+        free(raw);
+        return -1;
+    }
+    ok = fwrite(raw, 1, size, f) == size;
+    fclose(f);
+    free(raw);
+    return ok ? 0 : -1;
+}
+
+#endif